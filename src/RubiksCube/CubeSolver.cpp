@@ -7,6 +7,8 @@
 
 CubeSolver::CubeSolver(QObject *parent)
     : QObject(parent)
+    , m_statistics(QStringList() << "cross" << "first_layer_corners" << "middle_layer"
+                                 << "top_cross" << "orient_last_layer" << "permute_last_layer")
 {
     // Seed the random number generator
     qsrand(QTime::currentTime().msec());
@@ -63,8 +65,12 @@ QStringList CubeSolver::solve(CubeState* cubeState)
         return QStringList();
     }
     
+    m_counters = SolveCounters();
+    m_solveTimer.start();
+    
     if (cubeState->isSolved()) {
         qDebug() << "CubeSolver: Cube is already solved!";
+        recordSolve(true);
         return QStringList{"Cube is already solved!"};
     }
     
@@ -78,6 +84,8 @@ QStringList CubeSolver::solve(CubeState* cubeState)
     
     delete workingState;
     
+    recordSolve(!solution.isEmpty());
+    
     if (!solution.isEmpty()) {
         qDebug() << "CubeSolver: Solution found with" << solution.size() << "moves";
         return optimizeMoves(solution);
@@ -87,13 +95,51 @@ QStringList CubeSolver::solve(CubeState* cubeState)
     }
 }
 
+QStringList CubeSolver::runPhase(Phase phase, CubeState* state)
+{
+    qint64 start = m_solveTimer.nsecsElapsed();
+    
+    QStringList moves;
+    switch (phase) {
+    case PhaseCross:
+        moves = solveCross(state);
+        break;
+    case PhaseFirstLayerCorners:
+        moves = solveFirstLayerCorners(state);
+        break;
+    case PhaseMiddleLayer:
+        moves = solveMiddleLayer(state);
+        break;
+    case PhaseTopCross:
+        moves = solveTopCross(state);
+        break;
+    case PhaseOrientLastLayer:
+        moves = orientLastLayer(state);
+        break;
+    case PhasePermuteLastLayer:
+        moves = permuteLastLayer(state);
+        break;
+    }
+    
+    // A phase hits when it had work to do
+    m_counters.addTechnique(phase, !moves.isEmpty(), m_solveTimer.nsecsElapsed() - start);
+    return moves;
+}
+
+void CubeSolver::recordSolve(bool solved)
+{
+    m_counters.wallTimeNs = m_solveTimer.nsecsElapsed();
+    m_counters.solved = solved;
+    m_statistics.record(m_counters);
+}
+
 QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
 {
     QStringList totalSolution;
     
     // Phase 1: Solve the cross on the bottom (white cross)
     qDebug() << "CubeSolver: Phase 1 - Solving cross";
-    QStringList crossSolution = solveCross(state);
+    QStringList crossSolution = runPhase(PhaseCross, state);
     totalSolution.append(crossSolution);
     
     // Apply moves to the state
@@ -103,7 +149,7 @@ QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
     
     // Phase 2: Solve first layer corners
     qDebug() << "CubeSolver: Phase 2 - Solving first layer corners";
-    QStringList cornersSolution = solveFirstLayerCorners(state);
+    QStringList cornersSolution = runPhase(PhaseFirstLayerCorners, state);
     totalSolution.append(cornersSolution);
     
     for (const QString& move : cornersSolution) {
@@ -112,7 +158,7 @@ QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
     
     // Phase 3: Solve middle layer edges
     qDebug() << "CubeSolver: Phase 3 - Solving middle layer";
-    QStringList middleSolution = solveMiddleLayer(state);
+    QStringList middleSolution = runPhase(PhaseMiddleLayer, state);
     totalSolution.append(middleSolution);
     
     for (const QString& move : middleSolution) {
@@ -121,7 +167,7 @@ QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
     
     // Phase 4: Solve top cross
     qDebug() << "CubeSolver: Phase 4 - Solving top cross";
-    QStringList topCrossSolution = solveTopCross(state);
+    QStringList topCrossSolution = runPhase(PhaseTopCross, state);
     totalSolution.append(topCrossSolution);
     
     for (const QString& move : topCrossSolution) {
@@ -130,7 +176,7 @@ QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
     
     // Phase 5: Orient last layer (OLL)
     qDebug() << "CubeSolver: Phase 5 - Orienting last layer";
-    QStringList ollSolution = orientLastLayer(state);
+    QStringList ollSolution = runPhase(PhaseOrientLastLayer, state);
     totalSolution.append(ollSolution);
     
     for (const QString& move : ollSolution) {
@@ -139,7 +185,7 @@ QStringList CubeSolver::beginnerMethodSolve(CubeState* state)
     
     // Phase 6: Permute last layer (PLL)
     qDebug() << "CubeSolver: Phase 6 - Permuting last layer";
-    QStringList pllSolution = permuteLastLayer(state);
+    QStringList pllSolution = runPhase(PhasePermuteLastLayer, state);
     totalSolution.append(pllSolution);
     
     return totalSolution;
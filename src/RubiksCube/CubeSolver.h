@@ -5,7 +5,9 @@
 #include <QStringList>
 #include <QVector>
 #include <QMap>
+#include <QElapsedTimer>
 #include "CubeState.h"
+#include "Utils/SolverStatistics.h"
 
 class CubeSolver : public QObject
 {
@@ -14,11 +16,31 @@ class CubeSolver : public QObject
 public:
     explicit CubeSolver(QObject *parent = nullptr);
     ~CubeSolver();
-
+    
     // Main solving function
     QStringList solve(CubeState* cubeState);
+    
+    // Counters of the last solve and histograms over every solve since the
+    // last reset. Techniques are the six layer-by-layer phases; the method
+    // does not search, so nodes, propagations and depth stay at zero.
+    const SolveCounters& lastSolveCounters() const { return m_counters; }
+    const SolverStatistics& statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics.clear(); }
 
 private:
+    enum Phase {
+        PhaseCross,
+        PhaseFirstLayerCorners,
+        PhaseMiddleLayer,
+        PhaseTopCross,
+        PhaseOrientLastLayer,
+        PhasePermuteLastLayer
+    };
+    
+    // Runs one phase, timing it for the statistics
+    QStringList runPhase(Phase phase, CubeState* state);
+    void recordSolve(bool solved);
+    
     // Kociemba's algorithm implementation (simplified)
     QStringList kociembaSolve(CubeState* state);
     
@@ -69,6 +91,11 @@ private:
     QStringList m_tPermAlgorithm;
     QStringList m_yPermAlgorithm;
     QStringList m_ollerAlgorithm;
+    
+    // Solve statistics
+    SolveCounters m_counters;
+    SolverStatistics m_statistics;
+    QElapsedTimer m_solveTimer;
 };
 
 #endif // CUBESOLVER_H
\ No newline at end of file
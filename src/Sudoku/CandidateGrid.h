@@ -0,0 +1,158 @@
+#ifndef CANDIDATEGRID_H
+#define CANDIDATEGRID_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include "SudokuBoard.h"
+#include "CandidateKernel.h"
+#include "SudokuUnits.h"
+
+// Reversible record of the changes made to a CandidateGrid.
+//
+// Every entry removes at least one pencil mark and marks only come back
+// through undo, so no search path can record more than one entry per
+// (cell, digit) pair and the fixed capacity always suffices.
+struct CandidateTrail
+{
+    static constexpr int CAPACITY = SudokuBoard::CELL_COUNT * SudokuBoard::GRID_SIZE;
+    
+    struct Entry {
+        quint8 cell;
+        bool placed;            // The cell was filled, not just narrowed
+        quint16 candidates;     // Pencil marks before the change
+    };
+    
+    Entry entries[CAPACITY];
+    int size = 0;
+};
+
+// Pencil marks kept alongside a board for the human-style techniques.
+//
+// Candidates are computed once in load() by the whole-board kernel and afterwards only change for the
+// peers of a placed cell or through explicit eliminations, so techniques read
+// them without rescanning rows, columns and blocks. Like SudokuBoard it is a
+// plain value type. With a trail attached every change is recorded and can
+// be rolled back with undo().
+struct CandidateGrid
+{
+    static constexpr int GRID_SIZE = SudokuBoard::GRID_SIZE;
+    static constexpr int CELL_COUNT = SudokuBoard::CELL_COUNT;
+    
+    SudokuBoard board;
+    quint16 candidates[CandidateKernel::PADDED_CELLS];  // Bit value-1 set while the digit is possible, 0 for filled cells
+    int emptyCount;
+    CandidateTrail* trail = nullptr;
+    
+    void load(const SudokuBoard& source)
+    {
+        board = source;
+        CandidateKernel::compute(board, candidates);
+        emptyCount = 0;
+        for (int cell = 0; cell < CELL_COUNT; ++cell) {
+            if (board.cells[cell] == 0) {
+                emptyCount++;
+            }
+        }
+    }
+    
+    quint16 mask(int row, int col) const
+    {
+        return candidates[row * GRID_SIZE + col];
+    }
+    
+    bool isComplete() const
+    {
+        return emptyCount == 0;
+    }
+    
+    // Fills a cell and removes the digit from the pencil marks of its peers
+    void place(int row, int col, int value)
+    {
+        quint16 bit = SudokuBoard::digitBit(value);
+        int cell = row * GRID_SIZE + col;
+        record(cell, true);
+        board.place(row, col, value);
+        candidates[cell] = 0;
+        emptyCount--;
+        
+        const quint8* peers = SudokuUnits::peers(cell);
+        for (int i = 0; i < SudokuUnits::PEER_COUNT; ++i) {
+            removeMark(peers[i], bit);
+        }
+    }
+    
+    // Removes pencil marks from an empty cell; returns true if any were set
+    bool eliminate(int row, int col, quint16 digits)
+    {
+        int cell = row * GRID_SIZE + col;
+        if (!(candidates[cell] & digits)) {
+            return false;
+        }
+        record(cell, false);
+        candidates[cell] &= ~digits;
+        return true;
+    }
+    
+    // True when an empty cell has no candidates left, or a unit has no place left for a missing digit
+    bool hasContradiction() const
+    {
+        if (CandidateKernel::summarize(board, candidates).contradiction) {
+            return true;
+        }
+        
+        for (int row = 0; row < GRID_SIZE; ++row) {
+            quint16 rowDigits = board.rowMask[row];
+            quint16 colDigits = board.colMask[row];
+            quint16 blockDigits = board.blockMask[row];
+            const quint8* blockCells = SudokuUnits::cells(2 * GRID_SIZE + row);
+            
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                rowDigits |= candidates[row * GRID_SIZE + i];
+                colDigits |= candidates[i * GRID_SIZE + row];
+                blockDigits |= candidates[blockCells[i]];
+            }
+            
+            if ((rowDigits & colDigits & blockDigits) != SudokuBoard::ALL_DIGITS) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Rolls the grid back to an earlier trail size
+    void undo(int mark)
+    {
+        while (trail->size > mark) {
+            const CandidateTrail::Entry& entry = trail->entries[--trail->size];
+            if (entry.placed) {
+                board.erase(entry.cell / GRID_SIZE, entry.cell % GRID_SIZE);
+                emptyCount++;
+            }
+            candidates[entry.cell] = entry.candidates;
+        }
+    }
+
+private:
+    void record(int cell, bool placed)
+    {
+        if (trail) {
+            CandidateTrail::Entry& entry = trail->entries[trail->size++];
+            entry.cell = static_cast<quint8>(cell);
+            entry.placed = placed;
+            entry.candidates = candidates[cell];
+        }
+    }
+    
+    void removeMark(int cell, quint16 bit)
+    {
+        if (candidates[cell] & bit) {
+            record(cell, false);
+            candidates[cell] &= ~bit;
+        }
+    }
+};
+
+static_assert(std::is_trivially_copyable<CandidateGrid>::value,
+              "CandidateGrid must stay a plain value type");
+
+#endif // CANDIDATEGRID_H
@@ -0,0 +1,200 @@
+#include "CandidateKernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SUDOKU_KERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+inline void setBit(quint64 set[2], int cell)
+{
+    set[cell >> 6] |= quint64(1) << (cell & 63);
+}
+
+// Ors the low bits of a row into the cell bitset starting at its first cell
+inline void setRowBits(quint64 set[2], int first, quint32 bits)
+{
+    if (first < 64) {
+        set[0] |= quint64(bits) << first;
+        if (first > 64 - SudokuBoard::GRID_SIZE) {
+            set[1] |= quint64(bits) >> (64 - first);
+        }
+    } else {
+        set[1] |= quint64(bits) << (first - 64);
+    }
+}
+
+inline void classifyCell(CandidateSummary& summary, int cell, quint8 value, quint16 mask)
+{
+    if (value != 0) {
+        return;
+    }
+    if (mask == 0) {
+        summary.contradiction = true;
+    } else if ((mask & (mask - 1)) == 0) {
+        setBit(summary.singles, cell);
+    }
+}
+
+CandidateSummary computeScalar(const SudokuBoard& board, quint16* candidates)
+{
+    CandidateSummary summary = { { 0, 0 }, false };
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        int row = cell / SudokuBoard::GRID_SIZE;
+        int col = cell % SudokuBoard::GRID_SIZE;
+        quint16 mask = board.candidateMask(row, col);
+        candidates[cell] = mask;
+        classifyCell(summary, cell, board.cells[cell], mask);
+    }
+    
+    return summary;
+}
+
+CandidateSummary summarizeScalar(const SudokuBoard& board, const quint16* candidates)
+{
+    CandidateSummary summary = { { 0, 0 }, false };
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        classifyCell(summary, cell, board.cells[cell], candidates[cell]);
+    }
+    
+    return summary;
+}
+
+#ifdef SUDOKU_KERNEL_AVX2
+
+// One bit per 16-bit lane, lanes 0-7 in bits 0-7 and lanes 8-15 in bits 8-15
+__attribute__((target("avx2")))
+inline quint32 laneBits(__m256i lanes)
+{
+    __m256i packed = _mm256_packs_epi16(lanes, _mm256_setzero_si256());
+    quint32 bytes = static_cast<quint32>(_mm256_movemask_epi8(packed));
+    return (bytes & 0xFF) | ((bytes >> 8) & 0xFF00);
+}
+
+// Lanes that are empty cells with zero or exactly one candidate
+__attribute__((target("avx2")))
+inline void classifyLanes(__m256i mask, __m256i empty, quint32& deadBits, quint32& singleBits)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i none = _mm256_cmpeq_epi16(mask, zero);
+    __m256i lowest = _mm256_cmpeq_epi16(_mm256_and_si256(mask, _mm256_sub_epi16(mask, _mm256_set1_epi16(1))), zero);
+    
+    deadBits = laneBits(_mm256_and_si256(empty, none));
+    singleBits = laneBits(_mm256_andnot_si256(none, _mm256_and_si256(empty, lowest)));
+}
+
+// Nine cells per row: lanes 0-8 hold the row, lanes 9-15 are ignored
+__attribute__((target("avx2")))
+CandidateSummary computeAvx2(const SudokuBoard& board, quint16* candidates)
+{
+    CandidateSummary summary = { { 0, 0 }, false };
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i allDigits = _mm256_set1_epi16(static_cast<short>(SudokuBoard::ALL_DIGITS));
+    const quint32 rowLanes = (1u << SudokuBoard::GRID_SIZE) - 1;
+    
+    // Column masks line up with the cells of every row
+    __m128i colLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(board.colMask));
+    __m128i colHigh = _mm_cvtsi32_si128(board.colMask[8]);
+    __m256i columns = _mm256_inserti128_si256(_mm256_castsi128_si256(colLow), colHigh, 1);
+    
+    for (int band = 0; band < 3; ++band) {
+        const quint16* blocks = board.blockMask + band * 3;
+        __m256i bandBlocks = _mm256_setr_epi16(
+            blocks[0], blocks[0], blocks[0], blocks[1], blocks[1], blocks[1],
+            blocks[2], blocks[2], blocks[2], 0, 0, 0, 0, 0, 0, 0);
+        __m256i bandUsed = _mm256_or_si256(columns, bandBlocks);
+        
+        for (int row = band * 3; row < band * 3 + 3; ++row) {
+            const quint8* cells = board.cells + row * SudokuBoard::GRID_SIZE;
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cells));
+            bytes = _mm_insert_epi8(bytes, cells[8], 8);
+            __m256i values = _mm256_cvtepu8_epi16(bytes);
+            __m256i empty = _mm256_cmpeq_epi16(values, zero);
+            
+            __m256i used = _mm256_or_si256(bandUsed, _mm256_set1_epi16(static_cast<short>(board.rowMask[row])));
+            __m256i mask = _mm256_and_si256(_mm256_andnot_si256(used, allDigits), empty);
+            
+            // Lanes 9-15 spill into the next row, which overwrites them; the array is padded for the last row
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(candidates + row * SudokuBoard::GRID_SIZE), mask);
+            
+            quint32 deadBits;
+            quint32 singleBits;
+            classifyLanes(mask, empty, deadBits, singleBits);
+            if (deadBits & rowLanes) {
+                summary.contradiction = true;
+            }
+            setRowBits(summary.singles, row * SudokuBoard::GRID_SIZE, singleBits & rowLanes);
+        }
+    }
+    
+    return summary;
+}
+
+// Sixteen cells per step over the flat arrays, then the last cell on its own
+__attribute__((target("avx2")))
+CandidateSummary summarizeAvx2(const SudokuBoard& board, const quint16* candidates)
+{
+    CandidateSummary summary = { { 0, 0 }, false };
+    const __m256i zero = _mm256_setzero_si256();
+    
+    for (int first = 0; first + 16 <= SudokuBoard::CELL_COUNT; first += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(board.cells + first));
+        __m256i empty = _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(bytes), zero);
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(candidates + first));
+        
+        quint32 deadBits;
+        quint32 singleBits;
+        classifyLanes(mask, empty, deadBits, singleBits);
+        if (deadBits) {
+            summary.contradiction = true;
+        }
+        summary.singles[first >> 6] |= quint64(singleBits) << (first & 63);
+    }
+    
+    int last = SudokuBoard::CELL_COUNT - 1;
+    classifyCell(summary, last, board.cells[last], candidates[last]);
+    return summary;
+}
+
+bool detectAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // SUDOKU_KERNEL_AVX2
+
+} // namespace
+
+bool CandidateKernel::usesAvx2()
+{
+#ifdef SUDOKU_KERNEL_AVX2
+    static const bool available = detectAvx2();
+    return available;
+#else
+    return false;
+#endif
+}
+
+CandidateSummary CandidateKernel::compute(const SudokuBoard& board, quint16 candidates[PADDED_CELLS])
+{
+#ifdef SUDOKU_KERNEL_AVX2
+    if (usesAvx2()) {
+        return computeAvx2(board, candidates);
+    }
+#endif
+    return computeScalar(board, candidates);
+}
+
+CandidateSummary CandidateKernel::summarize(const SudokuBoard& board, const quint16* candidates)
+{
+#ifdef SUDOKU_KERNEL_AVX2
+    if (usesAvx2()) {
+        return summarizeAvx2(board, candidates);
+    }
+#endif
+    return summarizeScalar(board, candidates);
+}
@@ -0,0 +1,36 @@
+#ifndef CANDIDATEKERNEL_H
+#define CANDIDATEKERNEL_H
+
+#include <QtGlobal>
+#include "SudokuBoard.h"
+
+// What a whole-board candidate pass found besides the masks themselves
+struct CandidateSummary {
+    quint64 singles[2];     // Empty cells with exactly one candidate, bit = cell index
+    bool contradiction;     // Some empty cell has no candidate left
+};
+
+// Whole-board candidate kernels.
+//
+// Each call handles all 81 cells in one pass and reports naked singles and
+// dead cells along the way. On x86 CPUs with AVX2 the work runs nine or
+// sixteen cells per instruction; the choice is made once at runtime and
+// every other CPU uses the scalar version with identical results.
+class CandidateKernel
+{
+public:
+    // Output arrays are padded so vector stores may run past the last cell
+    static constexpr int PADDED_CELLS = 96;
+    
+    // Computes the candidate mask of every cell (0 for filled cells) from the
+    // row, column and block masks of the board
+    static CandidateSummary compute(const SudokuBoard& board, quint16 candidates[PADDED_CELLS]);
+    
+    // Summarises existing pencil marks, which may be narrower than the unit
+    // masks alone allow; reads exactly 81 entries
+    static CandidateSummary summarize(const SudokuBoard& board, const quint16* candidates);
+    
+    static bool usesAvx2();
+};
+
+#endif // CANDIDATEKERNEL_H
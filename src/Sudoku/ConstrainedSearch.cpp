@@ -0,0 +1,331 @@
+#include "ConstrainedSearch.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+
+inline void setBucketBit(quint64* bucket, int cell)
+{
+    bucket[cell >> 6] |= quint64(1) << (cell & 63);
+}
+
+inline void clearBucketBit(quint64* bucket, int cell)
+{
+    bucket[cell >> 6] &= ~(quint64(1) << (cell & 63));
+}
+
+} // namespace
+
+template<int BOX>
+BasicConstrainedSearch<BOX>::BasicConstrainedSearch()
+    : m_loaded(false)
+    , m_maxSolutions(1)
+    , m_solutionCount(0)
+    , m_nodesVisited(0)
+    , m_peakDepth(0)
+    , m_propagations(0)
+    , m_sharedCount(nullptr)
+    , m_stopFlag(nullptr)
+    , m_visitor(nullptr)
+    , m_monitor(nullptr)
+    , m_stopped(false)
+{
+    initialize(m_root);
+    m_solution.clear();
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::load(const Board& board)
+{
+    initialize(m_root);
+    m_loaded = false;
+    
+    for (int row = 0; row < GRID_SIZE; ++row) {
+        for (int col = 0; col < GRID_SIZE; ++col) {
+            int value = board.value(row, col);
+            if (value != 0 && !place(m_root, row * GRID_SIZE + col, value)) {
+                return false;
+            }
+        }
+    }
+    
+    m_loaded = true;
+    return true;
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::exclude(int cell, int value)
+{
+    if (m_loaded && !eliminate(m_root, cell, value)) {
+        m_loaded = false;
+    }
+    return m_loaded;
+}
+
+template<int BOX>
+qint64 BasicConstrainedSearch<BOX>::solve(qint64 maxSolutions)
+{
+    m_maxSolutions = maxSolutions;
+    m_solutionCount = 0;
+    m_nodesVisited = 0;
+    m_peakDepth = 0;
+    m_propagations = 0;
+    m_stopped = false;
+    
+    if (m_loaded) {
+        State state = m_root;
+        search(state, 0);
+    }
+    
+    return m_solutionCount;
+}
+
+template<int BOX>
+void BasicConstrainedSearch<BOX>::initialize(State& state)
+{
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        state.candidates[cell] = Board::ALL_DIGITS;
+        state.cells[cell] = 0;
+    }
+    
+    std::memset(state.places, GRID_SIZE, sizeof(state.places));
+    std::memset(state.placed, 0, sizeof(state.placed));
+    std::memset(state.hiddenSingles, 0, sizeof(state.hiddenSingles));
+    std::memset(state.buckets, 0, sizeof(state.buckets));
+    
+    // Every cell starts with all candidates
+    for (int word = 0; word < CELL_WORDS; ++word) {
+        int bits = qMin(64, CELL_COUNT - word * 64);
+        state.buckets[GRID_SIZE][word] = bits == 64 ? ~quint64(0) : (quint64(1) << bits) - 1;
+    }
+    state.emptyCount = CELL_COUNT;
+}
+
+// Removes one possible place for a digit in a unit, tracking hidden singles
+// and reporting a contradiction when an unplaced digit runs out of places.
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::dropPlace(State& state, int unit, int digit)
+{
+    Mask bit = Mask(Mask(1) << digit);
+    quint8 left = --state.places[unit][digit];
+    
+    if (state.placed[unit] & bit) {
+        return true;
+    }
+    
+    if (left == 1) {
+        state.hiddenSingles[unit] |= bit;
+    } else if (left == 0) {
+        state.hiddenSingles[unit] &= ~bit;
+        return false;
+    }
+    return true;
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::place(State& state, int cell, int value)
+{
+    Mask bit = Board::digitBit(value);
+    Mask candidates = state.candidates[cell];
+    
+    if (!(candidates & bit)) {
+        return false;
+    }
+    
+    clearBucketBit(state.buckets[qPopulationCount(candidates)], cell);
+    state.candidates[cell] = 0;
+    state.cells[cell] = static_cast<quint8>(value);
+    state.emptyCount--;
+    
+    for (int u = 0; u < 3; ++u) {
+        int unit = Units::units(cell)[u];
+        state.placed[unit] |= bit;
+        state.hiddenSingles[unit] &= ~bit;
+    }
+    
+    // The cell is no longer a place for any of its other candidates
+    Mask others = candidates & ~bit;
+    while (others) {
+        int digit = qCountTrailingZeroBits(others);
+        others &= others - 1;
+        for (int u = 0; u < 3; ++u) {
+            if (!dropPlace(state, Units::units(cell)[u], digit)) {
+                return false;
+            }
+        }
+    }
+    
+    // Peers lose the placed value
+    const typename Units::Index* peers = Units::peers(cell);
+    for (int i = 0; i < Units::PEER_COUNT; ++i) {
+        int peer = peers[i];
+        if (state.cells[peer] == 0 && !eliminate(state, peer, value)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::eliminate(State& state, int cell, int value)
+{
+    Mask bit = Board::digitBit(value);
+    Mask candidates = state.candidates[cell];
+    
+    if (!(candidates & bit)) {
+        return true;
+    }
+    
+    int count = qPopulationCount(candidates);
+    state.candidates[cell] = candidates & ~bit;
+    clearBucketBit(state.buckets[count], cell);
+    setBucketBit(state.buckets[count - 1], cell);
+    
+    for (int u = 0; u < 3; ++u) {
+        if (!dropPlace(state, Units::units(cell)[u], value - 1)) {
+            return false;
+        }
+    }
+    
+    return count > 1;
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::propagate(State& state)
+{
+    
+    while (state.emptyCount > 0) {
+        // Naked single: a cell with one candidate left
+        int cell = -1;
+        for (int word = 0; word < CELL_WORDS; ++word) {
+            if (state.buckets[1][word]) {
+                cell = word * 64 + qCountTrailingZeroBits(state.buckets[1][word]);
+                break;
+            }
+        }
+        
+        if (cell != -1) {
+            if (!place(state, cell, qCountTrailingZeroBits(state.candidates[cell]) + 1)) {
+                return false;
+            }
+            continue;
+        }
+        
+        // Hidden single: a digit with one place left in some unit
+        bool forced = false;
+        for (int unit = 0; unit < UNIT_COUNT && !forced; ++unit) {
+            if (!state.hiddenSingles[unit]) continue;
+            
+            int digit = qCountTrailingZeroBits(state.hiddenSingles[unit]);
+            Mask bit = Mask(Mask(1) << digit);
+            const typename Units::Index* cells = Units::cells(unit);
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                int target = cells[i];
+                if (state.candidates[target] & bit) {
+                    if (!place(state, target, digit + 1)) {
+                        return false;
+                    }
+                    forced = true;
+                    break;
+                }
+            }
+        }
+        
+        if (!forced) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
+template<int BOX>
+int BasicConstrainedSearch<BOX>::selectCell(const State& state)
+{
+    for (int count = 2; count <= GRID_SIZE; ++count) {
+        for (int word = 0; word < CELL_WORDS; ++word) {
+            if (state.buckets[count][word]) {
+                return word * 64 + qCountTrailingZeroBits(state.buckets[count][word]);
+            }
+        }
+    }
+    return -1;
+}
+
+template<int BOX>
+void BasicConstrainedSearch<BOX>::search(State& state, int depth)
+{
+    m_nodesVisited++;
+    m_peakDepth = qMax(m_peakDepth, depth);
+    
+    if (m_monitor && m_monitor->poll(depth)) {
+        m_stopped = true;
+        return;
+    }
+    
+    if (finished()) {
+        return; // Another subtree already settled the count, or the search was stopped
+    }
+    
+    int emptyBefore = state.emptyCount;
+    bool consistent = propagate(state);
+    m_propagations += emptyBefore - state.emptyCount;
+    if (!consistent) {
+        return;
+    }
+    
+    if (state.emptyCount == 0) {
+        if (m_solutionCount == 0 || m_visitor) {
+            m_solution.clear();
+            for (int cell = 0; cell < CELL_COUNT; ++cell) {
+                m_solution.place(cell / GRID_SIZE, cell % GRID_SIZE, state.cells[cell]);
+            }
+        }
+        m_solutionCount++;
+        if (m_sharedCount) {
+            m_sharedCount->fetchAndAddOrdered(1);
+        }
+        if (m_visitor && !(*m_visitor)(m_solution)) {
+            m_stopped = true;
+            if (m_stopFlag) {
+                m_stopFlag->storeRelease(1);
+            }
+        }
+        return;
+    }
+    
+    int cell = selectCell(state);
+    if (cell == -1) {
+        return;
+    }
+    
+    Mask candidates = state.candidates[cell];
+    while (candidates) {
+        int value = qCountTrailingZeroBits(candidates) + 1;
+        candidates &= candidates - 1;
+        
+        State child = state;
+        if (place(child, cell, value)) {
+            search(child, depth + 1);
+        }
+        
+        if (finished()) {
+            return;
+        }
+    }
+}
+
+template<int BOX>
+bool BasicConstrainedSearch<BOX>::finished() const
+{
+    return m_stopped || m_solutionCount >= m_maxSolutions ||
+           (m_sharedCount && m_sharedCount->loadAcquire() >= m_maxSolutions) ||
+           (m_stopFlag && m_stopFlag->loadAcquire() != 0);
+}
+
+// 4x4, 9x9, 16x16 and 25x25
+template class BasicConstrainedSearch<2>;
+template class BasicConstrainedSearch<3>;
+template class BasicConstrainedSearch<4>;
+template class BasicConstrainedSearch<5>;
@@ -0,0 +1,112 @@
+#ifndef CONSTRAINEDSEARCH_H
+#define CONSTRAINEDSEARCH_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <functional>
+#include "SudokuBoard.h"
+#include "SudokuUnits.h"
+#include "SolveControl.h"
+
+// Depth-first search that always branches on the most constrained cell.
+//
+// Candidate masks, per-cell candidate counts and per-unit digit place counts
+// are maintained incrementally as digits are placed, so choosing the next
+// cell never rescans the board. Naked and hidden singles are placed before
+// any branching happens.
+//
+// Sized at compile time by box dimension like BasicSudokuBoard; the
+// implementation is instantiated for box sizes 2 to 5 (4x4 to 25x25).
+template<int BOX>
+class BasicConstrainedSearch
+{
+public:
+    typedef BasicSudokuBoard<BOX> Board;
+    typedef typename Board::Mask Mask;
+    
+    // Receives each solution; returning false stops the search
+    typedef std::function<bool(const Board&)> Visitor;
+    
+    static constexpr int GRID_SIZE = Board::GRID_SIZE;
+    static constexpr int CELL_COUNT = Board::CELL_COUNT;
+    static constexpr int UNIT_COUNT = 3 * GRID_SIZE;
+    
+    BasicConstrainedSearch();
+    
+    // Loads the givens of a board; returns false if they already rule out every solution
+    bool load(const Board& board);
+    
+    // Rules out one digit in an empty cell of the loaded board; returns false
+    // if that already rules out every solution
+    bool exclude(int cell, int value);
+    
+    // Searches for up to maxSolutions solutions and returns how many were found.
+    // The first solution found (the latest one with a visitor) is kept and
+    // can be read with solution().
+    qint64 solve(qint64 maxSolutions);
+    
+    // Hands every solution found by solve() to a visitor. Without one, solve()
+    // only counts: no board is built past the first solution.
+    void setVisitor(const Visitor* visitor) { m_visitor = visitor; }
+    
+    const Board& solution() const { return m_solution; }
+    qint64 nodesVisited() const { return m_nodesVisited; }
+    
+    // Deepest guess level and cells filled by propagation in the last solve()
+    int peakDepth() const { return m_peakDepth; }
+    qint64 propagations() const { return m_propagations; }
+    
+    // Shares the solution count with searches of other subtrees running on
+    // other threads; every search stops once the shared count reaches maxSolutions
+    void setSharedCount(QAtomicInt* count) { m_sharedCount = count; }
+    
+    // Stops the search as soon as the flag is nonzero; the search also raises
+    // it when its visitor asks to stop, so sibling searches stop too
+    void setStopFlag(QAtomicInt* stop) { m_stopFlag = stop; }
+    
+    // Polls a monitor at every node and stops when it says so
+    void setMonitor(SearchMonitor* monitor) { m_monitor = monitor; }
+
+private:
+    typedef BasicSudokuUnits<BOX> Units;
+    static constexpr int CELL_WORDS = (CELL_COUNT + 63) / 64;
+    
+    struct State {
+        Mask candidates[CELL_COUNT];            // Remaining digits of each empty cell
+        quint8 cells[CELL_COUNT];               // Placed digits, 0 = empty
+        quint8 places[UNIT_COUNT][GRID_SIZE];   // Cells of each unit that can still take each digit
+        Mask placed[UNIT_COUNT];                // Digits already placed in each unit
+        Mask hiddenSingles[UNIT_COUNT];         // Unplaced digits with exactly one place left
+        quint64 buckets[GRID_SIZE + 1][CELL_WORDS];     // Empty cells grouped by candidate count
+        int emptyCount;
+    };
+    
+    static void initialize(State& state);
+    static bool place(State& state, int cell, int value);
+    static bool eliminate(State& state, int cell, int value);
+    static bool dropPlace(State& state, int unit, int digit);
+    static bool propagate(State& state);
+    static int selectCell(const State& state);
+    void search(State& state, int depth);
+    bool finished() const;
+    
+    State m_root;
+    bool m_loaded;
+    Board m_solution;
+    
+    qint64 m_maxSolutions;
+    qint64 m_solutionCount;
+    qint64 m_nodesVisited;
+    int m_peakDepth;
+    qint64 m_propagations;
+    QAtomicInt* m_sharedCount;
+    QAtomicInt* m_stopFlag;
+    const Visitor* m_visitor;
+    SearchMonitor* m_monitor;
+    bool m_stopped;
+};
+
+// The 9x9 search used by SudokuSolver and SudokuGenerator
+typedef BasicConstrainedSearch<3> ConstrainedSearch;
+
+#endif // CONSTRAINEDSEARCH_H
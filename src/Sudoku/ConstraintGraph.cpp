@@ -0,0 +1,275 @@
+#include "ConstraintGraph.h"
+#include "SudokuUnits.h"
+#include <QtAlgorithms>
+
+namespace {
+
+// Digit sets by size and sum: subsets[count][sum] lists every mask of count
+// distinct digits adding up to sum. Built once, 511 masks in all.
+struct DigitSubsets
+{
+    QVector<quint16> subsets[ConstraintGraph::GRID_SIZE + 1][ConstraintGraph::MAX_CAGE_SUM + 1];
+    
+    DigitSubsets()
+    {
+        for (int mask = 1; mask <= SudokuBoard::ALL_DIGITS; ++mask) {
+            int sum = 0;
+            for (int digit = 0; digit < ConstraintGraph::GRID_SIZE; ++digit) {
+                if (mask & (1 << digit)) {
+                    sum += digit + 1;
+                }
+            }
+            subsets[qPopulationCount(quint16(mask))][sum].append(quint16(mask));
+        }
+    }
+};
+
+const DigitSubsets& digitSubsets()
+{
+    static const DigitSubsets subsets;
+    return subsets;
+}
+
+} // namespace
+
+ConstraintGraph::ConstraintGraph()
+    : m_classic(true)
+{
+    for (int unit = 0; unit < CLASSIC_UNIT_COUNT; ++unit) {
+        QVector<int> cells;
+        for (int i = 0; i < GRID_SIZE; ++i) {
+            cells.append(SudokuUnits::cells(unit)[i]);
+        }
+        addUnit(UnitKind::House, cells, 0);
+    }
+    compile();
+}
+
+ConstraintGraph ConstraintGraph::diagonal()
+{
+    ConstraintGraph graph;
+    graph.addDiagonals();
+    return graph;
+}
+
+ConstraintGraph ConstraintGraph::antiKnight()
+{
+    ConstraintGraph graph;
+    graph.addAntiKnight();
+    return graph;
+}
+
+bool ConstraintGraph::setRegions(const QVector<int>& regionOfCell)
+{
+    if (regionOfCell.size() != CELL_COUNT) {
+        return false;
+    }
+    
+    QVector<int> regions[GRID_SIZE];
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        int region = regionOfCell[cell];
+        if (region < 0 || region >= GRID_SIZE || regions[region].size() == GRID_SIZE) {
+            return false;
+        }
+        regions[region].append(cell);
+    }
+    
+    for (int region = 0; region < GRID_SIZE; ++region) {
+        QVector<quint8>& cells = m_units[REGION_UNIT + region].cells;
+        for (int i = 0; i < GRID_SIZE; ++i) {
+            cells[i] = quint8(regions[region][i]);
+        }
+    }
+    m_classic = false;
+    compile();
+    return true;
+}
+
+void ConstraintGraph::addDiagonals()
+{
+    QVector<int> main;
+    QVector<int> anti;
+    for (int i = 0; i < GRID_SIZE; ++i) {
+        main.append(i * GRID_SIZE + i);
+        anti.append(i * GRID_SIZE + GRID_SIZE - 1 - i);
+    }
+    
+    addUnit(UnitKind::House, main, 0);
+    addUnit(UnitKind::House, anti, 0);
+    m_classic = false;
+    compile();
+}
+
+void ConstraintGraph::addAntiKnight()
+{
+    static const int MOVES[4][2] = { { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+    
+    // Moves pointing down the grid only, so each pair is added once
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        int row = cell / GRID_SIZE;
+        int col = cell % GRID_SIZE;
+        for (const int* move : MOVES) {
+            int otherRow = row + move[0];
+            int otherCol = col + move[1];
+            if (otherRow < GRID_SIZE && otherCol >= 0 && otherCol < GRID_SIZE) {
+                addUnit(UnitKind::Pair, QVector<int>() << cell << otherRow * GRID_SIZE + otherCol, 0);
+            }
+        }
+    }
+    m_classic = false;
+    compile();
+}
+
+bool ConstraintGraph::addHouse(const QVector<int>& cells)
+{
+    if (cells.size() != GRID_SIZE || !validCells(cells)) {
+        return false;
+    }
+    
+    addUnit(UnitKind::House, cells, 0);
+    m_classic = false;
+    compile();
+    return true;
+}
+
+bool ConstraintGraph::addCage(const QVector<int>& cells, int sum)
+{
+    if (cells.isEmpty() || !validCells(cells)) {
+        return false;
+    }
+    if (sum != 0 && sumDigits(cells.size(), sum, SudokuBoard::ALL_DIGITS) == 0) {
+        return false;
+    }
+    
+    addUnit(UnitKind::Cage, cells, sum);
+    m_classic = false;
+    compile();
+    return true;
+}
+
+bool ConstraintGraph::addPair(int cell, int other)
+{
+    QVector<int> cells;
+    cells << cell << other;
+    if (!validCells(cells)) {
+        return false;
+    }
+    
+    addUnit(UnitKind::Pair, cells, 0);
+    m_classic = false;
+    compile();
+    return true;
+}
+
+quint16 ConstraintGraph::sumDigits(int count, int sum, quint16 available)
+{
+    if (count < 0 || count > GRID_SIZE || sum < 0 || sum > MAX_CAGE_SUM) {
+        return 0;
+    }
+    
+    quint16 digits = 0;
+    for (quint16 subset : digitSubsets().subsets[count][sum]) {
+        if ((subset & ~available) == 0) {
+            digits |= subset;
+        }
+    }
+    return digits;
+}
+
+bool ConstraintGraph::validCells(const QVector<int>& cells) const
+{
+    if (cells.size() > GRID_SIZE) {
+        return false;
+    }
+    
+    quint64 seen[2] = { 0, 0 };
+    for (int cell : cells) {
+        if (cell < 0 || cell >= CELL_COUNT) {
+            return false;
+        }
+        quint64 bit = quint64(1) << (cell & 63);
+        if (seen[cell >> 6] & bit) {
+            return false;
+        }
+        seen[cell >> 6] |= bit;
+    }
+    return true;
+}
+
+void ConstraintGraph::addUnit(UnitKind kind, const QVector<int>& cells, int sum)
+{
+    Unit unit;
+    unit.kind = kind;
+    unit.sum = quint8(sum);
+    for (int cell : cells) {
+        unit.cells.append(quint8(cell));
+    }
+    m_units.append(unit);
+}
+
+void ConstraintGraph::compile()
+{
+    int unitCount = m_units.size();
+    m_unitKinds.resize(unitCount);
+    m_unitSums.resize(unitCount);
+    m_unitOffsets.resize(unitCount + 1);
+    m_unitCells.clear();
+    m_sumUnits.clear();
+    
+    QVector<int> cellUnitCounts(CELL_COUNT, 0);
+    for (int unit = 0; unit < unitCount; ++unit) {
+        const Unit& source = m_units[unit];
+        m_unitKinds[unit] = quint8(source.kind);
+        m_unitSums[unit] = source.sum;
+        m_unitOffsets[unit] = m_unitCells.size();
+        m_unitCells += source.cells;
+        if (source.sum != 0) {
+            m_sumUnits.append(quint16(unit));
+        }
+        for (quint8 cell : source.cells) {
+            cellUnitCounts[cell]++;
+        }
+    }
+    m_unitOffsets[unitCount] = m_unitCells.size();
+    
+    // Cell-to-unit lists in unit order
+    m_cellUnitOffsets.resize(CELL_COUNT + 1);
+    m_cellUnitOffsets[0] = 0;
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        m_cellUnitOffsets[cell + 1] = m_cellUnitOffsets[cell] + cellUnitCounts[cell];
+    }
+    m_cellUnits.resize(m_cellUnitOffsets[CELL_COUNT]);
+    QVector<int> fill = m_cellUnitOffsets;
+    for (int unit = 0; unit < unitCount; ++unit) {
+        for (quint8 cell : m_units[unit].cells) {
+            m_cellUnits[fill[cell]++] = quint16(unit);
+        }
+    }
+    
+    // Peers as bitsets first, which removes the duplicates, then as lists
+    m_peerBits.fill(0, CELL_COUNT * 2);
+    for (int unit = 0; unit < unitCount; ++unit) {
+        const QVector<quint8>& cells = m_units[unit].cells;
+        for (quint8 cell : cells) {
+            for (quint8 other : cells) {
+                if (other != cell) {
+                    m_peerBits[cell * 2 + (other >> 6)] |= quint64(1) << (other & 63);
+                }
+            }
+        }
+    }
+    
+    m_peerOffsets.resize(CELL_COUNT + 1);
+    m_peers.clear();
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        m_peerOffsets[cell] = m_peers.size();
+        for (int word = 0; word < 2; ++word) {
+            quint64 bits = m_peerBits[cell * 2 + word];
+            while (bits) {
+                m_peers.append(quint8(word * 64 + qCountTrailingZeroBits(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+    m_peerOffsets[CELL_COUNT] = m_peers.size();
+}
@@ -0,0 +1,111 @@
+#ifndef CONSTRAINTGRAPH_H
+#define CONSTRAINTGRAPH_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "SudokuBoard.h"
+
+// Constraint model of a 9x9 Sudoku variant, compiled into flat tables.
+//
+// Every constraint is a unit: a set of cells whose digits must differ.
+// Houses hold nine cells and so take every digit once, cages may also fix
+// the sum of their digits, and pairs are single extra peer relations such as
+// the anti-knight rule. Units 0 to 8 are rows, 9 to 17 columns and 18 to 26
+// the nine regions (the 3x3 blocks, or the pieces of a jigsaw); variant
+// units follow.
+//
+// Each edit recompiles the cell-to-unit and peer tables, so searches only
+// ever index arrays. Tables are implicitly shared: copying a graph is cheap.
+class ConstraintGraph
+{
+public:
+    static constexpr int GRID_SIZE = SudokuBoard::GRID_SIZE;
+    static constexpr int CELL_COUNT = SudokuBoard::CELL_COUNT;
+    static constexpr int REGION_UNIT = 2 * GRID_SIZE;
+    static constexpr int CLASSIC_UNIT_COUNT = 3 * GRID_SIZE;
+    static constexpr int MAX_CAGE_SUM = 45;
+    
+    enum class UnitKind : quint8 {
+        House,      // Nine cells, each digit exactly once
+        Cage,       // Distinct digits, with a fixed sum when sum() is nonzero
+        Pair        // Two cells that must differ
+    };
+    
+    // The classic rows, columns and blocks
+    ConstraintGraph();
+    
+    static ConstraintGraph classic() { return ConstraintGraph(); }
+    static ConstraintGraph diagonal();      // Both main diagonals are houses too
+    static ConstraintGraph antiKnight();    // Cells a knight's move apart differ
+    
+    // Replaces the blocks by irregular regions: regionOfCell holds a region
+    // 0 to 8 for every cell, nine cells per region. Returns false and leaves
+    // the graph unchanged if the layout is not like that.
+    bool setRegions(const QVector<int>& regionOfCell);
+    
+    void addDiagonals();
+    void addAntiKnight();
+    
+    // Extra units; each returns false and adds nothing when the cells are out
+    // of range, repeated, or cannot hold the sum
+    bool addHouse(const QVector<int>& cells);
+    bool addCage(const QVector<int>& cells, int sum = 0);
+    bool addPair(int cell, int other);
+    
+    // True while the graph has only the rows, columns and 3x3 blocks, which
+    // the classic solvers handle directly
+    bool isClassic() const { return m_classic; }
+    
+    int unitCount() const { return m_unitKinds.size(); }
+    UnitKind unitKind(int unit) const { return UnitKind(m_unitKinds[unit]); }
+    int unitSize(int unit) const { return m_unitOffsets[unit + 1] - m_unitOffsets[unit]; }
+    const quint8* unitCells(int unit) const { return m_unitCells.constData() + m_unitOffsets[unit]; }
+    int sum(int unit) const { return m_unitSums[unit]; }
+    
+    // Units containing a cell, rows first
+    int cellUnitCount(int cell) const { return m_cellUnitOffsets[cell + 1] - m_cellUnitOffsets[cell]; }
+    const quint16* cellUnits(int cell) const { return m_cellUnits.constData() + m_cellUnitOffsets[cell]; }
+    
+    // Cells sharing at least one unit with a cell, each listed once
+    int peerCount(int cell) const { return m_peerOffsets[cell + 1] - m_peerOffsets[cell]; }
+    const quint8* peers(int cell) const { return m_peers.constData() + m_peerOffsets[cell]; }
+    bool isPeer(int cell, int other) const
+    {
+        return (m_peerBits[cell * 2 + (other >> 6)] >> (other & 63)) & 1;
+    }
+    
+    // Units holding a sum: their indices, for searches that check sums
+    const QVector<quint16>& sumUnits() const { return m_sumUnits; }
+    
+    // Digits of available that appear in some set of count distinct digits
+    // taken from available and adding up to sum; 0 when there is none
+    static quint16 sumDigits(int count, int sum, quint16 available);
+
+private:
+    struct Unit {
+        UnitKind kind;
+        quint8 sum;
+        QVector<quint8> cells;
+    };
+    
+    bool validCells(const QVector<int>& cells) const;
+    void addUnit(UnitKind kind, const QVector<int>& cells, int sum);
+    void compile();
+    
+    QVector<Unit> m_units;
+    bool m_classic;
+    
+    // Compiled tables: unit cells, cell units and peers as offset arrays
+    QVector<quint8> m_unitKinds;
+    QVector<quint8> m_unitSums;
+    QVector<int> m_unitOffsets;
+    QVector<quint8> m_unitCells;
+    QVector<int> m_cellUnitOffsets;
+    QVector<quint16> m_cellUnits;
+    QVector<int> m_peerOffsets;
+    QVector<quint8> m_peers;
+    QVector<quint64> m_peerBits;    // Two words per cell
+    QVector<quint16> m_sumUnits;
+};
+
+#endif // CONSTRAINTGRAPH_H
@@ -0,0 +1,228 @@
+#include "DancingLinks.h"
+
+DancingLinks::DancingLinks()
+    : m_givenCount(0)
+    , m_maxSolutions(1)
+    , m_solutionCount(0)
+    , m_nodesVisited(0)
+    , m_peakDepth(0)
+    , m_forcedChoices(0)
+    , m_sharedCount(nullptr)
+    , m_monitor(nullptr)
+    , m_stopped(false)
+{
+    m_solution.clear();
+    buildMatrix();
+}
+
+void DancingLinks::buildMatrix()
+{
+    // Column headers form a circular list through the root
+    for (int c = 0; c <= COLUMN_COUNT; ++c) {
+        m_left[c] = static_cast<qint16>(c == 0 ? COLUMN_COUNT : c - 1);
+        m_right[c] = static_cast<qint16>(c == COLUMN_COUNT ? 0 : c + 1);
+        m_up[c] = static_cast<qint16>(c);
+        m_down[c] = static_cast<qint16>(c);
+        m_column[c] = static_cast<qint16>(c);
+        m_row[c] = -1;
+        m_size[c] = 0;
+    }
+    
+    // One matrix row per (cell, digit), each covering four constraints
+    for (int cell = 0; cell < 81; ++cell) {
+        int row = cell / 9;
+        int col = cell % 9;
+        int block = (row / 3) * 3 + (col / 3);
+        
+        for (int digit = 0; digit < 9; ++digit) {
+            int rowId = cell * 9 + digit;
+            int base = 1 + COLUMN_COUNT + rowId * 4;
+            int columns[4] = {
+                1 + cell,
+                1 + 81 + row * 9 + digit,
+                1 + 162 + col * 9 + digit,
+                1 + 243 + block * 9 + digit
+            };
+            
+            for (int k = 0; k < 4; ++k) {
+                int node = base + k;
+                int header = columns[k];
+                
+                m_left[node] = static_cast<qint16>(base + (k + 3) % 4);
+                m_right[node] = static_cast<qint16>(base + (k + 1) % 4);
+                
+                // Append to the bottom of the column
+                m_up[node] = m_up[header];
+                m_down[node] = static_cast<qint16>(header);
+                m_down[m_up[header]] = static_cast<qint16>(node);
+                m_up[header] = static_cast<qint16>(node);
+                
+                m_column[node] = static_cast<qint16>(header);
+                m_row[node] = static_cast<qint16>(rowId);
+                m_size[header]++;
+            }
+        }
+    }
+    
+    m_givenCount = 0;
+}
+
+bool DancingLinks::load(const SudokuBoard& board)
+{
+    buildMatrix();
+    
+    for (int row = 0; row < 9; ++row) {
+        for (int col = 0; col < 9; ++col) {
+            int value = board.value(row, col);
+            if (value == 0) {
+                continue;
+            }
+            
+            int rowId = (row * 9 + col) * 9 + (value - 1);
+            if (!selectRow(1 + COLUMN_COUNT + rowId * 4)) {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool DancingLinks::selectRow(int rowNode)
+{
+    // A given is only consistent if none of its constraints are already satisfied
+    int node = rowNode;
+    do {
+        int header = m_column[node];
+        if (m_right[m_left[header]] != header) {
+            return false;
+        }
+        node = m_right[node];
+    } while (node != rowNode);
+    
+    node = rowNode;
+    do {
+        cover(m_column[node]);
+        node = m_right[node];
+    } while (node != rowNode);
+    
+    m_stack[m_givenCount++] = m_row[rowNode];
+    return true;
+}
+
+int DancingLinks::solve(int maxSolutions)
+{
+    m_maxSolutions = maxSolutions;
+    m_solutionCount = 0;
+    m_nodesVisited = 0;
+    m_peakDepth = 0;
+    m_forcedChoices = 0;
+    m_stopped = false;
+    
+    search(m_givenCount);
+    
+    return m_solutionCount;
+}
+
+void DancingLinks::cover(int column)
+{
+    m_right[m_left[column]] = m_right[column];
+    m_left[m_right[column]] = m_left[column];
+    
+    for (int i = m_down[column]; i != column; i = m_down[i]) {
+        for (int j = m_right[i]; j != i; j = m_right[j]) {
+            m_down[m_up[j]] = m_down[j];
+            m_up[m_down[j]] = m_up[j];
+            m_size[m_column[j]]--;
+        }
+    }
+}
+
+void DancingLinks::uncover(int column)
+{
+    for (int i = m_up[column]; i != column; i = m_up[i]) {
+        for (int j = m_left[i]; j != i; j = m_left[j]) {
+            m_size[m_column[j]]++;
+            m_down[m_up[j]] = static_cast<qint16>(j);
+            m_up[m_down[j]] = static_cast<qint16>(j);
+        }
+    }
+    
+    m_right[m_left[column]] = static_cast<qint16>(column);
+    m_left[m_right[column]] = static_cast<qint16>(column);
+}
+
+void DancingLinks::search(int depth)
+{
+    m_nodesVisited++;
+    m_peakDepth = qMax(m_peakDepth, depth - m_givenCount);
+    
+    if (m_monitor && m_monitor->poll(depth - m_givenCount)) {
+        m_stopped = true;
+        return;
+    }
+    
+    if (m_sharedCount && m_sharedCount->loadAcquire() >= m_maxSolutions) {
+        return; // Another subtree already settled the count
+    }
+    
+    if (m_right[ROOT] == ROOT) {
+        // Every constraint is covered exactly once
+        if (m_solutionCount == 0) {
+            m_solution.clear();
+            for (int i = 0; i < depth; ++i) {
+                int cell = m_stack[i] / 9;
+                m_solution.place(cell / 9, cell % 9, m_stack[i] % 9 + 1);
+            }
+        }
+        m_solutionCount++;
+        if (m_sharedCount) {
+            m_sharedCount->fetchAndAddOrdered(1);
+        }
+        return;
+    }
+    
+    // Branch on the constraint with the fewest remaining options
+    int column = m_right[ROOT];
+    for (int c = m_right[column]; c != ROOT; c = m_right[c]) {
+        if (m_size[c] < m_size[column]) {
+            column = c;
+            if (m_size[column] <= 1) break;
+        }
+    }
+    
+    if (m_size[column] == 0) {
+        return; // Dead end
+    }
+    if (m_size[column] == 1) {
+        m_forcedChoices++;
+    }
+    
+    cover(column);
+    
+    for (int r = m_down[column]; r != column; r = m_down[r]) {
+        m_stack[depth] = m_row[r];
+        
+        for (int j = m_right[r]; j != r; j = m_right[j]) {
+            cover(m_column[j]);
+        }
+        
+        search(depth + 1);
+        
+        for (int j = m_left[r]; j != r; j = m_left[j]) {
+            uncover(m_column[j]);
+        }
+        
+        if (finished()) {
+            break;
+        }
+    }
+    
+    uncover(column);
+}
+
+bool DancingLinks::finished() const
+{
+    return m_stopped || m_solutionCount >= m_maxSolutions ||
+           (m_sharedCount && m_sharedCount->loadAcquire() >= m_maxSolutions);
+}
@@ -0,0 +1,79 @@
+#ifndef DANCINGLINKS_H
+#define DANCINGLINKS_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include "SudokuBoard.h"
+#include "SolveControl.h"
+
+// Knuth's Algorithm X over the 9x9 Sudoku exact-cover matrix.
+//
+// The matrix has 324 constraint columns (cell, row-digit, column-digit and
+// block-digit) and 729 candidate rows, one per (cell, digit). All links live
+// in fixed-size arrays inside the object, so loading and searching never
+// touch the heap.
+class DancingLinks
+{
+public:
+    DancingLinks();
+    
+    // Loads the givens of a board; returns false if they already clash
+    bool load(const SudokuBoard& board);
+    
+    // Searches for up to maxSolutions solutions and returns how many were found.
+    // The first solution found is kept and can be read with solution().
+    int solve(int maxSolutions);
+    
+    const SudokuBoard& solution() const { return m_solution; }
+    int nodesVisited() const { return m_nodesVisited; }
+    
+    // Deepest guess level in the last solve(), and the choices it made
+    // without a guess because a constraint had a single option left
+    int peakDepth() const { return m_peakDepth; }
+    qint64 forcedChoices() const { return m_forcedChoices; }
+    
+    // Shares the solution count with searches of other subtrees running on
+    // other threads; every search stops once the shared count reaches maxSolutions
+    void setSharedCount(QAtomicInt* count) { m_sharedCount = count; }
+    
+    // Polls a monitor at every node and stops when it says so
+    void setMonitor(SearchMonitor* monitor) { m_monitor = monitor; }
+
+private:
+    void buildMatrix();
+    void cover(int column);
+    void uncover(int column);
+    void search(int depth);
+    bool selectRow(int rowNode);
+    bool finished() const;
+    
+    static constexpr int COLUMN_COUNT = 324;
+    static constexpr int ROW_COUNT = 729;
+    static constexpr int NODE_COUNT = 1 + COLUMN_COUNT + ROW_COUNT * 4;
+    static constexpr int ROOT = 0;
+    
+    // Node pool; indices 1..324 are column headers
+    qint16 m_left[NODE_COUNT];
+    qint16 m_right[NODE_COUNT];
+    qint16 m_up[NODE_COUNT];
+    qint16 m_down[NODE_COUNT];
+    qint16 m_column[NODE_COUNT];
+    qint16 m_row[NODE_COUNT];
+    qint16 m_size[COLUMN_COUNT + 1];
+    
+    // Partial solution as matrix row ids (cell * 9 + digit - 1)
+    qint16 m_stack[81];
+    int m_givenCount;
+    SudokuBoard m_solution;
+    
+    int m_maxSolutions;
+    int m_solutionCount;
+    int m_nodesVisited;
+    int m_peakDepth;
+    qint64 m_forcedChoices;
+    QAtomicInt* m_sharedCount;
+    SearchMonitor* m_monitor;
+    bool m_stopped;
+};
+
+#endif // DANCINGLINKS_H
@@ -0,0 +1,240 @@
+#include "LaneSolver.h"
+#include "CandidateKernel.h"
+#include "SudokuUnits.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SUDOKU_LANES_AVX2 1
+#endif
+
+namespace {
+
+const int LANES = LaneSolver::LANE_COUNT;
+const int UNIT_COUNT = SudokuUnits::UNIT_COUNT;
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// Vectors only cross always-inline helpers inside this file, so the warning
+// about their calling convention differing between targets does not apply
+#ifndef __clang__
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// Sixteen 16-bit lanes; each function picks the widest registers its target has
+typedef quint16 LaneVector __attribute__((vector_size(LANES * sizeof(quint16))));
+
+// All bits set in lanes that are zero
+Q_ALWAYS_INLINE LaneVector zeroLanes(const LaneVector& v)
+{
+    return reinterpret_cast<LaneVector>(v == 0);
+}
+
+#else
+
+// Lane-by-lane stand-in for compilers without vector extensions
+struct LaneVector {
+    quint16 lane[LANES];
+    
+    quint16& operator[](int i) { return lane[i]; }
+    quint16 operator[](int i) const { return lane[i]; }
+};
+
+#define SUDOKU_LANE_OP(op) \
+    inline LaneVector operator op(LaneVector a, LaneVector b) \
+    { \
+        for (int i = 0; i < LANES; ++i) a.lane[i] = a.lane[i] op b.lane[i]; \
+        return a; \
+    } \
+    inline LaneVector& operator op##=(LaneVector& a, LaneVector b) { return a = a op b; }
+SUDOKU_LANE_OP(&)
+SUDOKU_LANE_OP(|)
+SUDOKU_LANE_OP(^)
+SUDOKU_LANE_OP(-)
+#undef SUDOKU_LANE_OP
+
+inline LaneVector operator~(LaneVector v)
+{
+    for (int i = 0; i < LANES; ++i) v.lane[i] = quint16(~v.lane[i]);
+    return v;
+}
+
+inline LaneVector zeroLanes(LaneVector v)
+{
+    for (int i = 0; i < LANES; ++i) v.lane[i] = v.lane[i] == 0 ? 0xFFFF : 0;
+    return v;
+}
+
+#endif
+
+Q_ALWAYS_INLINE LaneVector splat(quint16 value)
+{
+    LaneVector v;
+    for (int i = 0; i < LANES; ++i) {
+        v[i] = value;
+    }
+    return v;
+}
+
+// Pencil marks of every cell, one puzzle per lane
+struct LaneGrid {
+    LaneVector marks[SudokuBoard::CELL_COUNT];
+    LaneVector dead;        // Nonzero in lanes where a unit lost its last place for a digit
+};
+
+// Per-unit digit tallies of one propagation round
+struct UnitTally {
+    LaneVector singleOnce[UNIT_COUNT];
+    LaneVector singleTwice[UNIT_COUNT];
+    LaneVector markOnce[UNIT_COUNT];
+    LaneVector markTwice[UNIT_COUNT];
+};
+
+// The mark itself in lanes where exactly one digit is left, otherwise 0
+Q_ALWAYS_INLINE LaneVector singleOf(const LaneVector& marks, const LaneVector& one)
+{
+    return marks & zeroLanes(marks & (marks - one));
+}
+
+// One round over all lanes: tally singles and marks per unit, then remove
+// digits fixed elsewhere in a unit and narrow cells holding a hidden single.
+// A digit fixed twice in one unit is removed from both cells, which leaves
+// them empty and the lane dead. Returns true if any mark changed.
+//
+// Inlined into one function per instruction set, so the same code runs on
+// AVX2 registers or on pairs of SSE2 registers.
+Q_ALWAYS_INLINE bool propagateRound(LaneGrid& grid, UnitTally& tally)
+{
+    const LaneVector zero = splat(0);
+    const LaneVector one = splat(1);
+    const LaneVector allDigits = splat(SudokuBoard::ALL_DIGITS);
+    
+    for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+        tally.singleOnce[unit] = zero;
+        tally.singleTwice[unit] = zero;
+        tally.markOnce[unit] = zero;
+        tally.markTwice[unit] = zero;
+    }
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        const quint8* units = SudokuUnits::units(cell);
+        LaneVector marks = grid.marks[cell];
+        LaneVector single = singleOf(marks, one);
+        
+        for (int u = 0; u < 3; ++u) {
+            int unit = units[u];
+            tally.singleTwice[unit] |= tally.singleOnce[unit] & single;
+            tally.singleOnce[unit] |= single;
+            tally.markTwice[unit] |= tally.markOnce[unit] & marks;
+            tally.markOnce[unit] |= marks;
+        }
+    }
+    
+    for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+        grid.dead |= tally.markOnce[unit] ^ allDigits;
+    }
+    
+    LaneVector changed = zero;
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        const quint8* units = SudokuUnits::units(cell);
+        LaneVector marks = grid.marks[cell];
+        LaneVector single = singleOf(marks, one);
+        LaneVector removed = zero;
+        LaneVector hidden = zero;
+        
+        for (int u = 0; u < 3; ++u) {
+            int unit = units[u];
+            removed |= (tally.singleOnce[unit] & ~single) | (tally.singleTwice[unit] & single);
+            hidden |= tally.markOnce[unit] & ~tally.markTwice[unit];
+        }
+        
+        // Lanes with a hidden single keep only that digit
+        LaneVector narrowed = marks & ~removed;
+        LaneVector forced = narrowed & hidden;
+        narrowed = forced | (narrowed & zeroLanes(forced));
+        changed |= narrowed ^ marks;
+        grid.marks[cell] = narrowed;
+    }
+    
+    quint16 any = 0;
+    for (int i = 0; i < LANES; ++i) {
+        any |= changed[i];
+    }
+    return any != 0;
+}
+
+void propagateGeneric(LaneGrid& grid)
+{
+    UnitTally tally;
+    while (propagateRound(grid, tally)) {
+    }
+}
+
+#ifdef SUDOKU_LANES_AVX2
+
+// Same rounds with 16 lanes per AVX2 register
+__attribute__((target("avx2")))
+void propagateAvx2(LaneGrid& grid)
+{
+    UnitTally tally;
+    while (propagateRound(grid, tally)) {
+    }
+}
+
+#endif // SUDOKU_LANES_AVX2
+
+} // namespace
+
+void LaneSolver::propagate(SudokuBoard* boards, Outcome* outcomes, int count)
+{
+    Q_ASSERT(count <= LANE_COUNT);
+    
+    // Unused lanes stay empty boards, which propagation leaves alone
+    LaneGrid grid;
+    std::memset(&grid, 0, sizeof(LaneGrid));
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        for (int lane = 0; lane < LANE_COUNT; ++lane) {
+            int value = lane < count ? boards[lane].cells[cell] : 0;
+            grid.marks[cell][lane] = value != 0 ? SudokuBoard::digitBit(value) : SudokuBoard::ALL_DIGITS;
+        }
+    }
+
+#ifdef SUDOKU_LANES_AVX2
+    if (CandidateKernel::usesAvx2()) {
+        propagateAvx2(grid);
+    } else {
+        propagateGeneric(grid);
+    }
+#else
+    propagateGeneric(grid);
+#endif
+
+    for (int lane = 0; lane < count; ++lane) {
+        bool dead = grid.dead[lane] != 0;
+        bool complete = true;
+        for (int cell = 0; cell < SudokuBoard::CELL_COUNT && !dead; ++cell) {
+            quint16 mark = grid.marks[cell][lane];
+            if (mark == 0) {
+                dead = true;
+            } else if ((mark & (mark - 1)) != 0) {
+                complete = false;
+            }
+        }
+        
+        if (dead) {
+            outcomes[lane] = Outcome::Unsolvable;
+            continue;
+        }
+        
+        // At the fixed point no unit holds a digit twice, so the singles form a consistent board
+        SudokuBoard& board = boards[lane];
+        for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+            quint16 mark = grid.marks[cell][lane];
+            if (board.cells[cell] == 0 && (mark & (mark - 1)) == 0) {
+                board.place(cell / SudokuBoard::GRID_SIZE, cell % SudokuBoard::GRID_SIZE,
+                            qCountTrailingZeroBits(mark) + 1);
+            }
+        }
+        outcomes[lane] = complete ? Outcome::Solved : Outcome::NeedsSearch;
+    }
+}
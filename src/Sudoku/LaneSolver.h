@@ -0,0 +1,30 @@
+#ifndef LANESOLVER_H
+#define LANESOLVER_H
+
+#include <QtGlobal>
+#include "SudokuBoard.h"
+
+// Constraint propagation for many independent puzzles at once.
+//
+// Each puzzle occupies one 16-bit lane of every cell, so a single vector
+// instruction narrows the same cell of all puzzles together. Propagation
+// combines naked and hidden singles and runs until no lane changes; lanes it
+// cannot finish are left for the scalar search. Used by
+// SudokuSolver::solveBatch().
+class LaneSolver
+{
+public:
+    static constexpr int LANE_COUNT = 16;
+    
+    enum class Outcome : quint8 {
+        Solved,         // Propagation alone completed the board
+        Unsolvable,     // Some cell or unit ran out of candidates
+        NeedsSearch     // Stalled; the board holds every digit propagation fixed
+    };
+    
+    // Propagates up to LANE_COUNT consistent boards together. Boards that are
+    // not unsolvable receive every digit fixed by propagation.
+    static void propagate(SudokuBoard* boards, Outcome* outcomes, int count);
+};
+
+#endif // LANESOLVER_H
@@ -1,6 +1,8 @@
 #include "OCRProcessor.h"
 #include "SudokuGrid.h"
+#include "SudokuGenerator.h"
 #include <QDebug>
+#include <QRandomGenerator>
 #include <QDir>
 #include <QFileInfo>
 #include <QStandardPaths>
@@ -35,27 +37,11 @@ bool OCRProcessor::processPuzzle(const QString& imagePath, SudokuGrid* grid)
 
 bool OCRProcessor::generateSamplePuzzle(SudokuGrid* grid)
 {
-    // Generate a sample Sudoku puzzle for demonstration
+    // Stand in for a recognized image with a fresh random puzzle
     qDebug() << "OCRProcessor: Generating sample puzzle for demonstration";
     
-    // Sample puzzle (solvable)
-    int puzzle[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}
-    };
-    
-    for (int row = 0; row < 9; ++row) {
-        for (int col = 0; col < 9; ++col) {
-            grid->setValue(row, col, puzzle[row][col]);
-        }
-    }
+    SudokuGenerator generator(QRandomGenerator::global()->generate());
+    grid->setBoard(generator.generate(PuzzleDifficulty::Medium));
     
     return true;
 }
\ No newline at end of file
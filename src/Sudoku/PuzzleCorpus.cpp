@@ -0,0 +1,354 @@
+#include "PuzzleCorpus.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+// Records buffered by the writer before they go to the file
+const int WRITE_BUFFER_SIZE = 1 << 20;
+
+void writeHeader(uchar* header, quint16 payloads)
+{
+    std::memset(header, 0, PuzzleCorpus::HEADER_SIZE);
+    std::memcpy(header, PuzzleCorpus::MAGIC, sizeof(PuzzleCorpus::MAGIC));
+    qToLittleEndian<quint16>(PuzzleCorpus::VERSION, header + 4);
+    qToLittleEndian<quint16>(payloads, header + 6);
+    qToLittleEndian<quint32>(quint32(PuzzleCorpus::recordSize(payloads)), header + 8);
+}
+
+// Checks a header and reads its payloads
+bool readHeader(const uchar* header, quint16& payloads, QString& error)
+{
+    if (std::memcmp(header, PuzzleCorpus::MAGIC, sizeof(PuzzleCorpus::MAGIC)) != 0) {
+        error = "Not a puzzle corpus";
+        return false;
+    }
+    
+    quint16 version = qFromLittleEndian<quint16>(header + 4);
+    if (version != PuzzleCorpus::VERSION) {
+        error = QString("Unsupported corpus version %1").arg(version);
+        return false;
+    }
+    
+    payloads = qFromLittleEndian<quint16>(header + 6);
+    quint32 recordSize = qFromLittleEndian<quint32>(header + 8);
+    if (recordSize != quint32(PuzzleCorpus::recordSize(payloads))) {
+        error = QString("Corrupt corpus header: record size %1").arg(recordSize);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+const char PuzzleCorpus::MAGIC[4] = { 'S', 'D', 'K', 'C' };
+
+int PuzzleCorpus::recordSize(quint16 payloads)
+{
+    int size = RECORD_HEADER_SIZE + PACKED_BOARD_SIZE;
+    if (payloads & HasSolution) {
+        size += PACKED_BOARD_SIZE;
+    }
+    if (payloads & HasRating) {
+        size += RATING_SIZE;
+    }
+    return size;
+}
+
+bool PuzzleCorpus::isCorpusFile(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    char magic[sizeof(MAGIC)];
+    return file.read(magic, sizeof(magic)) == qint64(sizeof(magic)) &&
+           std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void PuzzleCorpus::packBoard(const SudokuBoard& board, uchar* packed)
+{
+    for (int i = 0; i < PACKED_BOARD_SIZE; ++i) {
+        int cell = i * 2;
+        uchar high = cell + 1 < SudokuBoard::CELL_COUNT ? board.cells[cell + 1] : 0;
+        packed[i] = uchar(board.cells[cell] | (high << 4));
+    }
+}
+
+bool PuzzleCorpus::unpackBoard(const uchar* packed, SudokuBoard& board)
+{
+    board.clear();
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        int value = (packed[cell >> 1] >> ((cell & 1) * 4)) & 0x0F;
+        if (value == 0) {
+            continue;
+        }
+        
+        int row = cell / SudokuBoard::GRID_SIZE;
+        int col = cell % SudokuBoard::GRID_SIZE;
+        if (value > SudokuBoard::GRID_SIZE || !board.canPlace(row, col, value)) {
+            return false;
+        }
+        board.place(row, col, value);
+    }
+    return true;
+}
+
+PuzzleCorpusReader::PuzzleCorpusReader()
+    : m_mapping(nullptr)
+    , m_records(nullptr)
+    , m_payloads(0)
+    , m_recordSize(0)
+    , m_count(0)
+{
+}
+
+PuzzleCorpusReader::~PuzzleCorpusReader()
+{
+    close();
+}
+
+bool PuzzleCorpusReader::open(const QString& fileName)
+{
+    close();
+    
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    
+    qint64 size = m_file.size();
+    if (size < PuzzleCorpus::HEADER_SIZE) {
+        m_error = "Not a puzzle corpus";
+        m_file.close();
+        return false;
+    }
+    
+    uchar* data = m_file.map(0, size);
+    if (!data) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    
+    m_mapping = data;
+    if (!readHeader(data, m_payloads, m_error)) {
+        close();
+        return false;
+    }
+    
+    // A partial record at the end, from an interrupted writer, is left out
+    m_recordSize = PuzzleCorpus::recordSize(m_payloads);
+    m_count = (size - PuzzleCorpus::HEADER_SIZE) / m_recordSize;
+    m_records = data + PuzzleCorpus::HEADER_SIZE;
+    return true;
+}
+
+void PuzzleCorpusReader::close()
+{
+    if (m_mapping) {
+        m_file.unmap(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_records = nullptr;
+    m_payloads = 0;
+    m_recordSize = 0;
+    m_count = 0;
+}
+
+bool PuzzleCorpusReader::puzzle(qint64 index, SudokuBoard& board) const
+{
+    return PuzzleCorpus::unpackBoard(record(index) + PuzzleCorpus::RECORD_HEADER_SIZE, board);
+}
+
+bool PuzzleCorpusReader::solution(qint64 index, SudokuBoard& board) const
+{
+    const uchar* data = record(index);
+    if (!(m_payloads & PuzzleCorpus::HasSolution) || !(data[0] & PuzzleCorpus::RecordSolved)) {
+        return false;
+    }
+    return PuzzleCorpus::unpackBoard(data + PuzzleCorpus::RECORD_HEADER_SIZE + PuzzleCorpus::PACKED_BOARD_SIZE,
+                                     board);
+}
+
+bool PuzzleCorpusReader::rating(qint64 index, SudokuRating& rating) const
+{
+    const uchar* data = record(index);
+    if (!(m_payloads & PuzzleCorpus::HasRating) || !(data[0] & PuzzleCorpus::RecordRated)) {
+        return false;
+    }
+    
+    // The rating payload closes the record
+    const uchar* payload = data + m_recordSize - PuzzleCorpus::RATING_SIZE;
+    rating = SudokuRating();
+    rating.rating = payload[0];
+    rating.pearl = payload[1];
+    rating.diamond = payload[2];
+    rating.solved = payload[3] != 0;
+    return true;
+}
+
+PuzzleCorpusWriter::PuzzleCorpusWriter()
+    : m_payloads(0)
+    , m_recordSize(0)
+    , m_count(0)
+    , m_failed(false)
+{
+}
+
+PuzzleCorpusWriter::~PuzzleCorpusWriter()
+{
+    close();
+}
+
+bool PuzzleCorpusWriter::open(const QString& fileName, quint16 payloads)
+{
+    close();
+    
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    
+    m_payloads = payloads;
+    m_recordSize = PuzzleCorpus::recordSize(payloads);
+    m_count = 0;
+    m_failed = false;
+    m_buffer.clear();
+    
+    qint64 size = m_file.size();
+    if (size == 0) {
+        uchar header[PuzzleCorpus::HEADER_SIZE];
+        writeHeader(header, payloads);
+        if (m_file.write(reinterpret_cast<const char*>(header), sizeof(header)) != qint64(sizeof(header))) {
+            m_error = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        return true;
+    }
+    
+    uchar header[PuzzleCorpus::HEADER_SIZE];
+    quint16 existing = 0;
+    if (size < PuzzleCorpus::HEADER_SIZE ||
+        m_file.read(reinterpret_cast<char*>(header), sizeof(header)) != qint64(sizeof(header))) {
+        m_error = "Not a puzzle corpus";
+        m_file.close();
+        return false;
+    }
+    if (!readHeader(header, existing, m_error)) {
+        m_file.close();
+        return false;
+    }
+    if (existing != payloads) {
+        m_error = "Corpus payloads differ from the ones being written";
+        m_file.close();
+        return false;
+    }
+    
+    qint64 end = PuzzleCorpus::HEADER_SIZE + (size - PuzzleCorpus::HEADER_SIZE) / m_recordSize * m_recordSize;
+    if ((end != size && !m_file.resize(end)) || !m_file.seek(end)) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool PuzzleCorpusWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return true;
+    }
+    
+    bool flushed = flush();
+    m_file.close();
+    return flushed;
+}
+
+uchar* PuzzleCorpusWriter::appendRecord(const SudokuBoard& puzzle, quint8 flags)
+{
+    int offset = m_buffer.size();
+    m_buffer.resize(offset + m_recordSize);
+    uchar* record = reinterpret_cast<uchar*>(m_buffer.data()) + offset;
+    std::memset(record, 0, m_recordSize);
+    
+    int givens = 0;
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        givens += puzzle.cells[cell] ? 1 : 0;
+    }
+    
+    record[0] = flags;
+    record[1] = uchar(givens);
+    PuzzleCorpus::packBoard(puzzle, record + PuzzleCorpus::RECORD_HEADER_SIZE);
+    m_count++;
+    return record;
+}
+
+bool PuzzleCorpusWriter::append(const SudokuBoard& puzzle, const SudokuBoard* solution,
+                                const SudokuRating* rating)
+{
+    if (m_failed || !m_file.isOpen()) {
+        return false;
+    }
+    
+    if (!(m_payloads & PuzzleCorpus::HasSolution)) {
+        solution = nullptr;
+    }
+    if (!(m_payloads & PuzzleCorpus::HasRating)) {
+        rating = nullptr;
+    }
+    
+    quint8 flags = (solution ? PuzzleCorpus::RecordSolved : 0) | (rating ? PuzzleCorpus::RecordRated : 0);
+    uchar* record = appendRecord(puzzle, flags);
+    
+    if (solution) {
+        PuzzleCorpus::packBoard(*solution, record + PuzzleCorpus::RECORD_HEADER_SIZE + PuzzleCorpus::PACKED_BOARD_SIZE);
+    }
+    if (rating) {
+        uchar* payload = record + m_recordSize - PuzzleCorpus::RATING_SIZE;
+        payload[0] = uchar(qBound(0, rating->rating, 255));
+        payload[1] = uchar(qBound(0, rating->pearl, 255));
+        payload[2] = uchar(qBound(0, rating->diamond, 255));
+        payload[3] = rating->solved ? 1 : 0;
+    }
+    
+    return m_buffer.size() < WRITE_BUFFER_SIZE || flush();
+}
+
+bool PuzzleCorpusWriter::appendUnsolvable(const SudokuBoard& puzzle)
+{
+    if (m_failed || !m_file.isOpen()) {
+        return false;
+    }
+    
+    appendRecord(puzzle, PuzzleCorpus::RecordUnsolvable);
+    return m_buffer.size() < WRITE_BUFFER_SIZE || flush();
+}
+
+bool PuzzleCorpusWriter::flush()
+{
+    if (m_failed) {
+        return false;
+    }
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+    
+    // A failed or short write keeps the buffer and fails the writer for good;
+    // a partial record it leaves on disk is cut off by the next open()
+    if (m_file.write(m_buffer) != m_buffer.size()) {
+        m_error = m_file.errorString();
+        m_failed = true;
+        return false;
+    }
+    m_buffer.clear();
+    return true;
+}
@@ -0,0 +1,143 @@
+#ifndef PUZZLECORPUS_H
+#define PUZZLECORPUS_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include "SudokuBoard.h"
+#include "SudokuRating.h"
+
+// Packed binary file of 9x9 puzzles.
+//
+// A 16-byte file header is followed by fixed-size records, so record i sits
+// at HEADER_SIZE + i * recordSize and readers index the file directly:
+//
+//   header   magic "SDKC", quint16 version, quint16 payloads,
+//            quint32 record size, quint32 reserved (little-endian)
+//   record   quint8 flags, quint8 given count, quint16 reserved,
+//            41 bytes puzzle (two cells per byte, low nibble first, 0 = empty),
+//            41 bytes solution     if the file has HasSolution,
+//            4 bytes rating        if the file has HasRating: rating, pearl and
+//                                  diamond in tenths, then 1 when the techniques
+//                                  finished the puzzle
+//
+// Every record of a file has the same payloads; the record flags say which of
+// them are filled in.
+struct PuzzleCorpus
+{
+    // File payloads
+    enum Payload : quint16 {
+        HasSolution = 0x0001,
+        HasRating = 0x0002
+    };
+    
+    // Record flags
+    enum RecordFlag : quint8 {
+        RecordSolved = 0x01,        // Solution payload holds the solution
+        RecordRated = 0x02,         // Rating payload is filled in
+        RecordUnsolvable = 0x04     // The givens conflict or have no solution
+    };
+    
+    static constexpr quint16 VERSION = 1;
+    static constexpr int HEADER_SIZE = 16;
+    static constexpr int RECORD_HEADER_SIZE = 4;
+    static constexpr int PACKED_BOARD_SIZE = (SudokuBoard::CELL_COUNT + 1) / 2;
+    static constexpr int RATING_SIZE = 4;
+    
+    static const char MAGIC[4];
+    
+    static int recordSize(quint16 payloads);
+    
+    // True if the file starts with a corpus header
+    static bool isCorpusFile(const QString& fileName);
+    
+    static void packBoard(const SudokuBoard& board, uchar* packed);
+    
+    // Returns false if a nibble is not a digit or the digits conflict
+    static bool unpackBoard(const uchar* packed, SudokuBoard& board);
+};
+
+// Read-only view of a corpus file mapped into memory.
+//
+// Nothing is read up front: record() points straight into the mapping and
+// puzzle() decodes 41 bytes, so any number of threads can walk the records
+// of one reader at once.
+class PuzzleCorpusReader
+{
+public:
+    PuzzleCorpusReader();
+    ~PuzzleCorpusReader();
+    
+    bool open(const QString& fileName);
+    void close();
+    
+    bool isOpen() const { return m_records != nullptr; }
+    QString errorString() const { return m_error; }
+    
+    quint16 payloads() const { return m_payloads; }
+    int recordSize() const { return m_recordSize; }
+    qint64 count() const { return m_count; }
+    
+    const uchar* record(qint64 index) const { return m_records + index * m_recordSize; }
+    quint8 recordFlags(qint64 index) const { return record(index)[0]; }
+    int givenCount(qint64 index) const { return record(index)[1]; }
+    
+    // Returns false if the givens conflict
+    bool puzzle(qint64 index, SudokuBoard& board) const;
+    
+    // Return false if the record has no solution or rating filled in
+    bool solution(qint64 index, SudokuBoard& board) const;
+    bool rating(qint64 index, SudokuRating& rating) const;
+
+private:
+    QFile m_file;
+    uchar* m_mapping;
+    const uchar* m_records;
+    quint16 m_payloads;
+    int m_recordSize;
+    qint64 m_count;
+    QString m_error;
+};
+
+// Appends records to a corpus file, creating it with a header when it is
+// new or empty. Records are buffered and written in large blocks.
+class PuzzleCorpusWriter
+{
+public:
+    PuzzleCorpusWriter();
+    ~PuzzleCorpusWriter();
+    
+    // An existing corpus must have the same payloads. A partial record left
+    // at the end by an interrupted writer is cut off.
+    bool open(const QString& fileName, quint16 payloads);
+    bool close();
+    
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_error; }
+    
+    // Payloads the file does not carry are dropped. Both return false once a
+    // write has failed: the writer then refuses records and close() fails too.
+    bool append(const SudokuBoard& puzzle, const SudokuBoard* solution = nullptr,
+                const SudokuRating* rating = nullptr);
+    bool appendUnsolvable(const SudokuBoard& puzzle);
+    
+    bool flush();
+    bool hasFailed() const { return m_failed; }
+    
+    // Records appended since open()
+    qint64 count() const { return m_count; }
+
+private:
+    uchar* appendRecord(const SudokuBoard& puzzle, quint8 flags);
+    
+    QFile m_file;
+    QByteArray m_buffer;
+    quint16 m_payloads;
+    int m_recordSize;
+    qint64 m_count;
+    bool m_failed;              // A write failed; sticky until the next open()
+    QString m_error;
+};
+
+#endif // PUZZLECORPUS_H
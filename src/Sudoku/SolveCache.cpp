@@ -0,0 +1,83 @@
+#include "SolveCache.h"
+#include <QMutexLocker>
+
+SolveCache::SolveCache(int capacity)
+    : m_entries(capacity)
+{
+}
+
+SolveCache& SolveCache::global()
+{
+    static SolveCache instance;
+    return instance;
+}
+
+bool SolveCache::findSolution(const QByteArray& key, bool& solved, SudokuBoard& solution)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    // object() also marks the entry as most recently used
+    Entry* cached = m_entries.object(key);
+    if (!cached || !cached->hasSolution) {
+        return false;
+    }
+    
+    solved = cached->solved;
+    solution = cached->solution;
+    return true;
+}
+
+bool SolveCache::findSteps(const QByteArray& key, QVector<SolutionStep>& steps)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    Entry* cached = m_entries.object(key);
+    if (!cached || !cached->hasSteps) {
+        return false;
+    }
+    
+    steps = cached->steps;
+    return true;
+}
+
+void SolveCache::insertSolution(const QByteArray& key, bool solved, const SudokuBoard& solution)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    Entry* cached = entry(key);
+    cached->hasSolution = true;
+    cached->solved = solved;
+    cached->solution = solution;
+}
+
+void SolveCache::insertSteps(const QByteArray& key, const QVector<SolutionStep>& steps)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    Entry* cached = entry(key);
+    cached->hasSteps = true;
+    cached->steps = steps;
+}
+
+void SolveCache::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.setMaxCost(capacity);
+}
+
+void SolveCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+SolveCache::Entry* SolveCache::entry(const QByteArray& key)
+{
+    Entry* cached = m_entries.object(key);
+    if (!cached) {
+        cached = new Entry;
+        cached->solution.clear();
+        m_entries.insert(key, cached);
+    }
+    return cached;
+}
@@ -0,0 +1,48 @@
+#ifndef SOLVECACHE_H
+#define SOLVECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QVector>
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+
+// Bounded least-recently-used cache of solve results keyed by canonical form.
+//
+// Entries are stored in canonical coordinates and digits, so one entry
+// answers every puzzle isomorphic to it; callers map results back through
+// the SudokuTransform of their own puzzle. All methods are thread-safe.
+class SolveCache
+{
+public:
+    explicit SolveCache(int capacity = 1024);
+    
+    // Cache shared by every solver in the process
+    static SolveCache& global();
+    
+    bool findSolution(const QByteArray& key, bool& solved, SudokuBoard& solution);
+    bool findSteps(const QByteArray& key, QVector<SolutionStep>& steps);
+    
+    void insertSolution(const QByteArray& key, bool solved, const SudokuBoard& solution);
+    void insertSteps(const QByteArray& key, const QVector<SolutionStep>& steps);
+    
+    void setCapacity(int capacity);
+    void clear();
+
+private:
+    struct Entry {
+        bool hasSolution = false;
+        bool solved = false;
+        SudokuBoard solution;
+        bool hasSteps = false;
+        QVector<SolutionStep> steps;
+    };
+    
+    Entry* entry(const QByteArray& key);
+    
+    QMutex m_mutex;
+    QCache<QByteArray, Entry> m_entries;
+};
+
+#endif // SOLVECACHE_H
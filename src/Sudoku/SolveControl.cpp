@@ -0,0 +1,36 @@
+#include "SolveControl.h"
+
+SearchMonitor::SearchMonitor(const CancellationToken& token, QDeadlineTimer deadline,
+                             const ProgressCallback& progress, int progressIntervalMs)
+    : m_token(token)
+    , m_deadline(deadline)
+    , m_progress(progress)
+    , m_progressIntervalMs(progressIntervalMs)
+    , m_nodes(0)
+    , m_peakDepth(0)
+    , m_reason(StopReason::None)
+{
+    m_sinceProgress.start();
+}
+
+bool SearchMonitor::check(int depth)
+{
+    if (m_reason != StopReason::None) {
+        return true;
+    }
+    
+    if (m_token.isCancelled()) {
+        m_reason = StopReason::Cancelled;
+        return true;
+    }
+    if (m_deadline.hasExpired()) {
+        m_reason = StopReason::DeadlineExpired;
+        return true;
+    }
+    
+    if (m_progress && m_sinceProgress.elapsed() >= m_progressIntervalMs) {
+        m_sinceProgress.restart();
+        m_progress(m_nodes, depth);
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+#ifndef SOLVECONTROL_H
+#define SOLVECONTROL_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <functional>
+
+// Lets the caller of an asynchronous solve stop it. Copies share one flag,
+// so the token handed to a solve can be cancelled from any thread.
+class CancellationToken
+{
+public:
+    CancellationToken() : m_cancelled(new QAtomicInt(0)) {}
+    
+    void cancel() { m_cancelled->storeRelease(1); }
+    bool isCancelled() const { return m_cancelled->loadAcquire() != 0; }
+
+private:
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+// Why a monitored search stopped before it finished
+enum class StopReason : quint8 {
+    None,
+    Cancelled,
+    DeadlineExpired
+};
+
+// Polled by the search engines at every node they visit.
+//
+// Only every POLL_INTERVAL-th poll looks at the token and the clock, so a
+// poll normally costs an increment and a compare. Progress is reported from
+// the searching thread, at most once per progress interval. One monitor
+// watches one single-threaded search.
+class SearchMonitor
+{
+public:
+    typedef std::function<void(qint64 nodes, int depth)> ProgressCallback;
+    
+    static constexpr int POLL_INTERVAL = 1024;
+    
+    SearchMonitor(const CancellationToken& token, QDeadlineTimer deadline,
+                  const ProgressCallback& progress = ProgressCallback(), int progressIntervalMs = 100);
+    
+    // Counts a node at the given search depth; true once the search should stop
+    bool poll(int depth)
+    {
+        m_nodes++;
+        if (depth > m_peakDepth) {
+            m_peakDepth = depth;
+        }
+        if ((m_nodes & (POLL_INTERVAL - 1)) != 0) {
+            return m_reason != StopReason::None;
+        }
+        return check(depth);
+    }
+    
+    bool stopped() const { return m_reason != StopReason::None; }
+    StopReason reason() const { return m_reason; }
+    qint64 nodes() const { return m_nodes; }
+    int peakDepth() const { return m_peakDepth; }
+
+private:
+    bool check(int depth);
+    
+    CancellationToken m_token;
+    QDeadlineTimer m_deadline;
+    ProgressCallback m_progress;
+    int m_progressIntervalMs;
+    QElapsedTimer m_sinceProgress;
+    
+    qint64 m_nodes;
+    int m_peakDepth;
+    StopReason m_reason;
+};
+
+#endif // SOLVECONTROL_H
@@ -0,0 +1,110 @@
+#ifndef SUDOKUBOARD_H
+#define SUDOKUBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <cstring>
+#include <type_traits>
+
+// Narrowest unsigned type with one bit per digit of a size x size grid
+template<int DIGITS, bool FITS16 = (DIGITS <= 16), bool FITS32 = (DIGITS <= 32)>
+struct SudokuMaskType { typedef quint64 Type; };
+
+template<int DIGITS, bool FITS32>
+struct SudokuMaskType<DIGITS, true, FITS32> { typedef quint16 Type; };
+
+template<int DIGITS>
+struct SudokuMaskType<DIGITS, false, true> { typedef quint32 Type; };
+
+// Plain board used inside the solvers, sized at compile time by its box
+// dimension: BOX = 3 is the classic 9x9 grid, 2 gives 4x4 and 4 or 5 give
+// 16x16 and 25x25. Digit masks use the narrowest type that holds every digit.
+//
+// Unlike SudokuGrid this is not a QObject: it emits no signals, lives on the
+// stack and copies with a memcpy. place() and erase() assume the board stays
+// free of duplicate digits, which holds for every board the search builds.
+template<int BOX>
+struct BasicSudokuBoard
+{
+    static_assert(BOX >= 2 && BOX <= 8, "Box sizes from 2 (4x4) to 8 (64x64) are supported");
+    
+    typedef typename SudokuMaskType<BOX * BOX>::Type Mask;
+    
+    static constexpr int GRID_SIZE = BOX * BOX;
+    static constexpr int BLOCK_SIZE = BOX;
+    static constexpr int CELL_COUNT = GRID_SIZE * GRID_SIZE;
+    static constexpr Mask ALL_DIGITS = Mask(Mask(~Mask(0)) >> (sizeof(Mask) * 8 - GRID_SIZE));
+    
+    quint8 cells[CELL_COUNT];       // Row-major, 0 = empty
+    Mask rowMask[GRID_SIZE];        // Bit value-1 set when the digit is used
+    Mask colMask[GRID_SIZE];
+    Mask blockMask[GRID_SIZE];
+    
+    static Mask digitBit(int value) { return Mask(Mask(1) << (value - 1)); }
+    static int blockIndex(int row, int col) { return (row / BLOCK_SIZE) * BLOCK_SIZE + col / BLOCK_SIZE; }
+    
+    void clear()
+    {
+        std::memset(this, 0, sizeof(BasicSudokuBoard));
+    }
+    
+    int value(int row, int col) const
+    {
+        return cells[row * GRID_SIZE + col];
+    }
+    
+    Mask candidateMask(int row, int col) const
+    {
+        if (cells[row * GRID_SIZE + col] != 0) {
+            return 0;
+        }
+        Mask used = rowMask[row] | colMask[col] | blockMask[blockIndex(row, col)];
+        return Mask(~used & ALL_DIGITS);
+    }
+    
+    bool canPlace(int row, int col, int value) const
+    {
+        return (candidateMask(row, col) & digitBit(value)) != 0;
+    }
+    
+    void place(int row, int col, int value)
+    {
+        Mask bit = digitBit(value);
+        cells[row * GRID_SIZE + col] = static_cast<quint8>(value);
+        rowMask[row] |= bit;
+        colMask[col] |= bit;
+        blockMask[blockIndex(row, col)] |= bit;
+    }
+    
+    void erase(int row, int col)
+    {
+        int value = cells[row * GRID_SIZE + col];
+        if (value == 0) {
+            return;
+        }
+        
+        Mask bit = digitBit(value);
+        cells[row * GRID_SIZE + col] = 0;
+        rowMask[row] &= ~bit;
+        colMask[col] &= ~bit;
+        blockMask[blockIndex(row, col)] &= ~bit;
+    }
+    
+    bool isComplete() const
+    {
+        for (int row = 0; row < GRID_SIZE; ++row) {
+            if (rowMask[row] != ALL_DIGITS) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// The classic 9x9 board every 9x9-only part of the engine works on
+typedef BasicSudokuBoard<3> SudokuBoard;
+
+static_assert(std::is_trivially_copyable<SudokuBoard>::value,
+              "SudokuBoard must stay a plain value type");
+
+#endif // SUDOKUBOARD_H
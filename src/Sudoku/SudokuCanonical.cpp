@@ -0,0 +1,307 @@
+#include "SudokuCanonical.h"
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+// Search states beyond this are dropped; very symmetric boards such as an
+// almost empty grid then get a valid but not fully canonical form
+const int MAX_STATES = 1 << 16;
+
+// All 6^4 column orders that keep stacks intact: stack order times the
+// order of the three columns inside each stack. Index
+// ((stacks * 6 + a) * 6 + b) * 6 + c uses stack order perms[stacks] and
+// inner orders perms[a], perms[b], perms[c].
+struct ColumnOrders {
+    int perms[6][3];
+    quint8 order[1296][9];
+    quint8 patterns[6][8];      // 3-bit given pattern of a stack after each inner order, first column high
+    
+    ColumnOrders()
+        : perms{ {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0} }
+    {
+        for (int p = 0; p < 6; ++p) {
+            for (int bits = 0; bits < 8; ++bits) {
+                int pattern = 0;
+                for (int k = 0; k < 3; ++k) {
+                    if (bits & (1 << perms[p][k])) {
+                        pattern |= 4 >> k;
+                    }
+                }
+                patterns[p][bits] = static_cast<quint8>(pattern);
+            }
+        }
+        
+        int index = 0;
+        for (int stacks = 0; stacks < 6; ++stacks) {
+            for (int a = 0; a < 6; ++a) {
+                for (int b = 0; b < 6; ++b) {
+                    for (int c = 0; c < 6; ++c) {
+                        const int inner[3] = { a, b, c };
+                        for (int s = 0; s < 3; ++s) {
+                            int stack = perms[stacks][s];
+                            for (int k = 0; k < 3; ++k) {
+                                order[index][s * 3 + k] = static_cast<quint8>(stack * 3 + perms[inner[s]][k]);
+                            }
+                        }
+                        index++;
+                    }
+                }
+            }
+        }
+    }
+};
+
+const ColumnOrders& columnOrders()
+{
+    static const ColumnOrders instance;
+    return instance;
+}
+
+// Partial transformation: the rows chosen so far and the digit labels they introduced
+struct SearchState {
+    quint8 transposed;
+    quint16 columns;        // Index into ColumnOrders
+    quint16 rowsUsed;
+    quint8 rowOrder[9];
+    quint8 labels[10];      // Source digit -> canonical digit, 0 = not yet seen
+    quint8 nextLabel;
+};
+
+} // namespace
+
+int SudokuTransform::sourceCell(int row, int col) const
+{
+    int sourceRow = rowOrder[row];
+    int sourceCol = colOrder[col];
+    return transposed ? sourceCol * 9 + sourceRow : sourceRow * 9 + sourceCol;
+}
+
+int SudokuTransform::sourceUnit(int unit) const
+{
+    if (unit < 9) {
+        int line = rowOrder[unit];
+        return transposed ? 9 + line : line;
+    }
+    
+    if (unit < 18) {
+        int line = colOrder[unit - 9];
+        return transposed ? line : 9 + line;
+    }
+    
+    // Bands and stacks move as a whole, so any cell of the block finds its source block
+    int block = unit - 18;
+    int cell = sourceCell((block / 3) * 3, (block % 3) * 3);
+    return 18 + SudokuBoard::blockIndex(cell / 9, cell % 9);
+}
+
+quint16 SudokuTransform::sourceMask(quint16 mask) const
+{
+    quint16 result = 0;
+    while (mask) {
+        int digit = qCountTrailingZeroBits(mask) + 1;
+        mask &= mask - 1;
+        result |= SudokuBoard::digitBit(digits[digit]);
+    }
+    return result;
+}
+
+SudokuBoard SudokuTransform::toSource(const SudokuBoard& canonical) const
+{
+    SudokuBoard board;
+    board.clear();
+    for (int row = 0; row < 9; ++row) {
+        for (int col = 0; col < 9; ++col) {
+            int value = canonical.value(row, col);
+            if (value != 0) {
+                int cell = sourceCell(row, col);
+                board.place(cell / 9, cell % 9, digits[value]);
+            }
+        }
+    }
+    return board;
+}
+
+SudokuBoard SudokuCanonical::canonicalize(const SudokuBoard& board, SudokuTransform& transform)
+{
+    const ColumnOrders& orders = columnOrders();
+    
+    // Both orientations of the source
+    quint8 source[2][81];
+    for (int row = 0; row < 9; ++row) {
+        for (int col = 0; col < 9; ++col) {
+            source[0][row * 9 + col] = board.cells[row * 9 + col];
+            source[1][col * 9 + row] = board.cells[row * 9 + col];
+        }
+    }
+    
+    QVector<SearchState> states;
+    QVector<SearchState> next;
+    
+    // Every digit of the first row gets a fresh label, so its output depends
+    // only on which columns hold givens. Rank each orientation, row and column
+    // order by that pattern alone before building any state.
+    SearchState start;
+    std::memset(&start, 0, sizeof(start));
+    int bestPattern = 1 << 9;
+    
+    for (int t = 0; t < 2; ++t) {
+        for (int row = 0; row < 9; ++row) {
+            int stackBits[3] = { 0, 0, 0 };
+            for (int col = 0; col < 9; ++col) {
+                if (source[t][row * 9 + col] != 0) {
+                    stackBits[col / 3] |= 1 << (col % 3);
+                }
+            }
+            
+            int index = 0;
+            for (int stacks = 0; stacks < 6; ++stacks) {
+                const int* stackOrder = orders.perms[stacks];
+                for (int a = 0; a < 6; ++a) {
+                    int high = orders.patterns[a][stackBits[stackOrder[0]]] << 6;
+                    for (int b = 0; b < 6; ++b) {
+                        int middle = high | orders.patterns[b][stackBits[stackOrder[1]]] << 3;
+                        for (int c = 0; c < 6; ++c, ++index) {
+                            int pattern = middle | orders.patterns[c][stackBits[stackOrder[2]]];
+                            if (pattern > bestPattern) continue;
+                            
+                            if (pattern < bestPattern) {
+                                bestPattern = pattern;
+                                states.clear();
+                            }
+                            
+                            if (states.size() < MAX_STATES) {
+                                start.transposed = static_cast<quint8>(t);
+                                start.columns = static_cast<quint16>(index);
+                                start.rowOrder[0] = static_cast<quint8>(row);
+                                states.append(start);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    quint8 canonical[81];
+    
+    for (SearchState& state : states) {
+        const quint8* grid = source[state.transposed];
+        const quint8* columns = orders.order[state.columns];
+        int row = state.rowOrder[0];
+        
+        state.rowsUsed = static_cast<quint16>(1u << row);
+        for (int col = 0; col < 9; ++col) {
+            int digit = grid[row * 9 + columns[col]];
+            if (digit != 0 && state.labels[digit] == 0) {
+                state.labels[digit] = ++state.nextLabel;
+            }
+            canonical[col] = state.labels[digit];
+        }
+    }
+    
+    // Choose the remaining rows one at a time, keeping every partial
+    // transformation whose output so far ties for the smallest
+    for (int level = 1; level < 9; ++level) {
+        quint8* best = canonical + level * 9;
+        bool haveBest = false;
+        next.clear();
+        
+        for (const SearchState& state : states) {
+            const quint8* grid = source[state.transposed];
+            const quint8* columns = orders.order[state.columns];
+            
+            // A new band may start on any unused band, otherwise stay in the current one
+            quint16 allowed;
+            if (level % 3 == 0) {
+                allowed = 0;
+                for (int band = 0; band < 3; ++band) {
+                    if (!(state.rowsUsed & (7u << (band * 3)))) {
+                        allowed |= 7u << (band * 3);
+                    }
+                }
+            } else {
+                allowed = (7u << ((state.rowOrder[level - 1] / 3) * 3)) & ~state.rowsUsed;
+            }
+            
+            while (allowed) {
+                int row = qCountTrailingZeroBits(allowed);
+                allowed &= allowed - 1;
+                
+                quint8 labels[10];
+                std::memcpy(labels, state.labels, sizeof(labels));
+                int nextLabel = state.nextLabel;
+                quint8 output[9];
+                int order = haveBest ? 0 : -1;
+                
+                for (int col = 0; col < 9 && order <= 0; ++col) {
+                    int digit = grid[row * 9 + columns[col]];
+                    if (digit != 0 && labels[digit] == 0) {
+                        labels[digit] = static_cast<quint8>(++nextLabel);
+                    }
+                    output[col] = labels[digit];
+                    
+                    if (order == 0) {
+                        if (output[col] < best[col]) {
+                            order = -1;
+                        } else if (output[col] > best[col]) {
+                            order = 1;
+                        }
+                    }
+                }
+                
+                if (order > 0) {
+                    continue;
+                }
+                
+                if (order < 0) {
+                    std::memcpy(best, output, 9);
+                    haveBest = true;
+                    next.clear();
+                }
+                
+                if (next.size() < MAX_STATES) {
+                    SearchState child = state;
+                    std::memcpy(child.labels, labels, sizeof(labels));
+                    child.nextLabel = static_cast<quint8>(nextLabel);
+                    child.rowOrder[level] = static_cast<quint8>(row);
+                    child.rowsUsed |= 1u << row;
+                    next.append(child);
+                }
+            }
+        }
+        
+        states.swap(next);
+    }
+    
+    // Any surviving state produces the same board
+    const SearchState& chosen = states.first();
+    transform.transposed = chosen.transposed != 0;
+    std::memcpy(transform.rowOrder, chosen.rowOrder, 9);
+    std::memcpy(transform.colOrder, orders.order[chosen.columns], 9);
+    
+    // Digits missing from the board take the remaining labels in ascending order
+    int nextLabel = chosen.nextLabel;
+    transform.digits[0] = 0;
+    for (int digit = 1; digit <= 9; ++digit) {
+        int label = chosen.labels[digit];
+        if (label == 0) {
+            label = ++nextLabel;
+        }
+        transform.digits[label] = static_cast<quint8>(digit);
+    }
+    
+    SudokuBoard result;
+    result.clear();
+    for (int cell = 0; cell < 81; ++cell) {
+        if (canonical[cell] != 0) {
+            result.place(cell / 9, cell % 9, canonical[cell]);
+        }
+    }
+    return result;
+}
+
+QByteArray SudokuCanonical::key(const SudokuBoard& canonical)
+{
+    return QByteArray(reinterpret_cast<const char*>(canonical.cells), SudokuBoard::CELL_COUNT);
+}
@@ -0,0 +1,50 @@
+#ifndef SUDOKUCANONICAL_H
+#define SUDOKUCANONICAL_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include "SudokuBoard.h"
+
+// Validity-preserving transformation from a board to its canonical form.
+//
+// Canonical cell (row, col) comes from cell (rowOrder[row], colOrder[col]) of
+// the source board, read transposed when transposed is set, and canonical
+// digit d stands for source digit digits[d].
+struct SudokuTransform
+{
+    bool transposed;
+    quint8 rowOrder[9];
+    quint8 colOrder[9];
+    quint8 digits[10];
+    
+    // Source cell index of a canonical cell
+    int sourceCell(int row, int col) const;
+    
+    // Source unit of a canonical unit (0-8 rows, 9-17 columns, 18-26 blocks)
+    int sourceUnit(int unit) const;
+    
+    int sourceDigit(int digit) const { return digits[digit]; }
+    quint16 sourceMask(quint16 mask) const;
+    
+    // Maps a board in canonical form back to source coordinates and digits
+    SudokuBoard toSource(const SudokuBoard& canonical) const;
+};
+
+// Canonical form of a puzzle under the Sudoku symmetry group: transposition,
+// band and stack permutations, row and column permutations inside them, and
+// digit relabeling.
+//
+// The canonical board is the lexicographically smallest row-major string over
+// all transformations, with empty cells smallest and digits renumbered in
+// order of first appearance, so isomorphic puzzles share one key.
+class SudokuCanonical
+{
+public:
+    // Returns the canonical board and the transformation that produced it
+    static SudokuBoard canonicalize(const SudokuBoard& board, SudokuTransform& transform);
+    
+    // 81-byte cache key of a canonical board
+    static QByteArray key(const SudokuBoard& canonical);
+};
+
+#endif // SUDOKUCANONICAL_H
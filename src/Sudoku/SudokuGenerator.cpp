@@ -0,0 +1,173 @@
+#include "SudokuGenerator.h"
+#include <QtConcurrent>
+
+namespace {
+
+// Generates one slot of a batch with its own seed
+struct BatchGenerator {
+    QVector<SudokuBoard>* puzzles;
+    QVector<bool>* inBand;          // Sized like puzzles, or null
+    PuzzleDifficulty difficulty;
+    quint32 seed;
+    
+    void operator()(int index) const
+    {
+        // Spread neighbouring indices across the seed space
+        SudokuGenerator generator(seed ^ (quint32(index) * 0x9E3779B9u));
+        bool met = true;
+        (*puzzles)[index] = generator.generate(difficulty, nullptr, &met);
+        if (inBand) {
+            (*inBand)[index] = met;
+        }
+    }
+};
+
+} // namespace
+
+SudokuGenerator::SudokuGenerator(quint32 seed)
+    : m_random(seed)
+{
+}
+
+SudokuBoard SudokuGenerator::randomSolution()
+{
+    SudokuBoard board;
+    board.clear();
+    fillRandom(board);
+    return board;
+}
+
+bool SudokuGenerator::fillRandom(SudokuBoard& board)
+{
+    // Branch on the empty cell with the fewest candidates
+    int bestCell = -1;
+    int fewest = 10;
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT && fewest > 1; ++cell) {
+        if (board.cells[cell] != 0) continue;
+        
+        int count = qPopulationCount(board.candidateMask(cell / 9, cell % 9));
+        if (count < fewest) {
+            bestCell = cell;
+            fewest = count;
+        }
+    }
+    
+    if (bestCell == -1) {
+        return true;
+    }
+    if (fewest == 0) {
+        return false;
+    }
+    
+    int row = bestCell / 9;
+    int col = bestCell % 9;
+    quint16 candidates = board.candidateMask(row, col);
+    
+    // Try the candidates in random order
+    while (candidates) {
+        int pick = m_random.bounded(qPopulationCount(candidates));
+        quint16 remaining = candidates;
+        for (int i = 0; i < pick; ++i) {
+            remaining &= remaining - 1;
+        }
+        int value = qCountTrailingZeroBits(remaining) + 1;
+        candidates &= ~SudokuBoard::digitBit(value);
+        
+        board.place(row, col, value);
+        if (fillRandom(board)) {
+            return true;
+        }
+        board.erase(row, col);
+    }
+    
+    return false;
+}
+
+SudokuBoard SudokuGenerator::generate(PuzzleDifficulty difficulty, SudokuBoard* solution, bool* inBand)
+{
+    SudokuBoard full;
+    SudokuBoard puzzle;
+    bool met = false;
+    
+    // Hard attempts whose minimal puzzle stays singles-solvable start over with a new grid
+    for (int attempt = 0; attempt < MAX_HARD_ATTEMPTS && !met; ++attempt) {
+        full = randomSolution();
+        puzzle = full;
+        met = removeGivens(puzzle, difficulty);
+    }
+    
+    if (solution) {
+        *solution = full;
+    }
+    if (inBand) {
+        *inBand = met;
+    }
+    return puzzle;
+}
+
+bool SudokuGenerator::removeGivens(SudokuBoard& puzzle, PuzzleDifficulty difficulty)
+{
+    int order[SudokuBoard::CELL_COUNT];
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        order[cell] = cell;
+    }
+    for (int i = SudokuBoard::CELL_COUNT - 1; i > 0; --i) {
+        qSwap(order[i], order[m_random.bounded(i + 1)]);
+    }
+    
+    bool singlesOnly = difficulty != PuzzleDifficulty::Hard;
+    int minGivens = difficulty == PuzzleDifficulty::Easy ? EASY_GIVENS : 0;
+    int givens = SudokuBoard::CELL_COUNT;
+    
+    // Removing givens only ever adds solutions, so a cell that cannot go now never can
+    for (int i = 0; i < SudokuBoard::CELL_COUNT && givens > minGivens; ++i) {
+        int cell = order[i];
+        int row = cell / 9;
+        int col = cell % 9;
+        int value = puzzle.value(row, col);
+        
+        puzzle.erase(row, col);
+        
+        // Solving by singles alone already proves the solution unique
+        bool keep = singlesOnly ? solvesWithSingles(puzzle) : keepsUniqueSolution(puzzle, cell, value);
+        if (keep) {
+            givens--;
+        } else {
+            puzzle.place(row, col, value);
+        }
+    }
+    
+    return singlesOnly || !solvesWithSingles(puzzle);
+}
+
+bool SudokuGenerator::solvesWithSingles(const SudokuBoard& puzzle)
+{
+    // The search places singles before it ever branches, so one node means no guess
+    return m_search.load(puzzle) && m_search.solve(1) == 1 && m_search.nodesVisited() == 1;
+}
+
+bool SudokuGenerator::keepsUniqueSolution(const SudokuBoard& puzzle, int cell, int value)
+{
+    // Unique exactly when no solution puts another digit in the emptied cell
+    if (!m_search.load(puzzle) || !m_search.exclude(cell, value)) {
+        return true;
+    }
+    return m_search.solve(1) == 0;
+}
+
+QVector<SudokuBoard> SudokuGenerator::generateBatch(int count, PuzzleDifficulty difficulty, quint32 seed,
+                                                    QVector<bool>* inBand)
+{
+    QVector<SudokuBoard> puzzles(count);
+    if (inBand) {
+        inBand->fill(true, count);
+    }
+    QVector<int> indices(count);
+    for (int i = 0; i < count; ++i) {
+        indices[i] = i;
+    }
+    
+    BatchGenerator generator = { &puzzles, inBand, difficulty, seed };
+    QtConcurrent::blockingMap(indices, generator);
+    return puzzles;
+}
@@ -0,0 +1,62 @@
+#ifndef SUDOKUGENERATOR_H
+#define SUDOKUGENERATOR_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QRandomGenerator>
+#include "SudokuBoard.h"
+#include "ConstrainedSearch.h"
+
+// How much work a generated puzzle asks of the player
+enum class PuzzleDifficulty {
+    Easy,       // Naked and hidden singles only, at least EASY_GIVENS givens
+    Medium,     // Naked and hidden singles only, as few givens as that allows
+    Hard        // Needs more than singles; no given can be removed
+};
+
+// Random puzzle generator.
+//
+// Fills a random complete grid, then removes givens in random order while
+// the puzzle keeps a unique solution. Every removal is checked
+// incrementally: the current puzzle's only solution is known, so removing
+// the given d from a cell keeps it unique exactly when no solution has
+// something other than d there, which is a single "any solution?" search
+// with d ruled out in that cell.
+class SudokuGenerator
+{
+public:
+    static constexpr int EASY_GIVENS = 34;
+    static constexpr int MAX_HARD_ATTEMPTS = 64;    // Fresh grids a Hard request tries
+    
+    explicit SudokuGenerator(quint32 seed);
+    
+    // Random complete, valid grid
+    SudokuBoard randomSolution();
+    
+    // Generates a puzzle with a unique solution in the requested band; the
+    // solution is stored when a pointer is given. A Hard request gives up
+    // after MAX_HARD_ATTEMPTS grids whose minimal puzzles singles alone can
+    // solve, and returns the last of them: the puzzle is still unique and
+    // minimal, but not Hard. inBand is then set to false.
+    SudokuBoard generate(PuzzleDifficulty difficulty, SudokuBoard* solution = nullptr, bool* inBand = nullptr);
+    
+    // Generates count puzzles on all cores. Puzzle i depends only on seed
+    // and i, so a batch is reproducible whatever the thread count. Hard
+    // slots take the same fallback as generate() and may hold puzzles that
+    // singles solve; inBand, when given, gets each slot's flag.
+    static QVector<SudokuBoard> generateBatch(int count, PuzzleDifficulty difficulty, quint32 seed,
+                                              QVector<bool>* inBand = nullptr);
+
+private:
+    bool fillRandom(SudokuBoard& board);
+    
+    // Removes givens of a solved board; false when a Hard attempt stayed singles-solvable
+    bool removeGivens(SudokuBoard& puzzle, PuzzleDifficulty difficulty);
+    bool solvesWithSingles(const SudokuBoard& puzzle);
+    bool keepsUniqueSolution(const SudokuBoard& puzzle, int cell, int value);
+    
+    QRandomGenerator m_random;
+    ConstrainedSearch m_search;
+};
+
+#endif // SUDOKUGENERATOR_H
@@ -1,6 +1,7 @@
 #include "SudokuGrid.h"
 #include <QDebug>
-#include <QSet>
+#include <QtAlgorithms>
+#include <cstring>
 
 SudokuGrid::SudokuGrid(QObject *parent)
     : QObject(parent)
@@ -10,80 +11,67 @@ SudokuGrid::SudokuGrid(QObject *parent)
 
 void SudokuGrid::initializeGrid()
 {
-    m_grid.resize(GRID_SIZE);
-    for (int i = 0; i < GRID_SIZE; ++i) {
-        m_grid[i].resize(GRID_SIZE);
-        for (int j = 0; j < GRID_SIZE; ++j) {
-            m_grid[i][j] = 0; // 0 represents empty cell
+    // 0 represents empty cell
+    int unitCount = m_graph.unitCount();
+    m_board.clear();
+    m_digitCount.fill(0, unitCount * (GRID_SIZE + 1));
+    m_unitMasks.fill(0, unitCount);
+    m_duplicates.fill(0, unitCount);
+    m_unitSums.fill(0, unitCount);
+    m_unitFilled.fill(0, unitCount);
+    m_sumBroken.fill(false, unitCount);
+    std::memset(m_conflicts, 0, sizeof(m_conflicts));
+    m_conflictCount = 0;
+    m_filledCount = 0;
+}
+
+void SudokuGrid::setConstraintGraph(const ConstraintGraph& graph)
+{
+    SudokuBoard values = m_board;
+    m_graph = graph;
+    initializeGrid();
+    
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        if (values.cells[index] != 0) {
+            assignCell(index, values.cells[index]);
         }
     }
+    
+    emit gridChanged();
+}
+
+const ConstraintGraph& SudokuGrid::constraintGraph() const
+{
+    return m_graph;
 }
 
 void SudokuGrid::reset()
 {
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            m_grid[row][col] = 0;
-        }
-    }
+    initializeGrid();
     emit gridChanged();
 }
 
 bool SudokuGrid::isValid() const
 {
-    // Check all rows, columns, and blocks for conflicts
-    for (int i = 0; i < GRID_SIZE; ++i) {
-        if (!isRowValid(i) || !isColumnValid(i)) {
-            return false;
-        }
-    }
-    
-    // Check all 3x3 blocks
-    for (int blockRow = 0; blockRow < 3; ++blockRow) {
-        for (int blockCol = 0; blockCol < 3; ++blockCol) {
-            if (!isBlockValid(blockRow, blockCol)) {
-                return false;
-            }
-        }
-    }
-    
-    return true;
+    // Any duplicate in a unit puts at least two cells in conflict, and a broken
+    // cage sum at least one
+    return m_conflictCount == 0;
 }
 
 bool SudokuGrid::isSolved() const
 {
-    if (!isValid()) {
-        return false;
-    }
-    
-    // Check if all cells are filled
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (m_grid[row][col] == 0) {
-                return false;
-            }
-        }
-    }
-    
-    return true;
+    return m_conflictCount == 0 && m_filledCount == CELL_COUNT;
 }
 
 bool SudokuGrid::isEmpty() const
 {
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (m_grid[row][col] != 0) {
-                return false;
-            }
-        }
-    }
-    return true;
+    return m_filledCount == 0;
 }
 
 int SudokuGrid::getValue(int row, int col) const
 {
     if (isValidPosition(row, col)) {
-        return m_grid[row][col];
+        return m_board.cells[row * GRID_SIZE + col];
     }
     return 0;
 }
@@ -98,8 +86,8 @@ void SudokuGrid::setValue(int row, int col, int value)
         return;
     }
     
-    int oldValue = m_grid[row][col];
-    m_grid[row][col] = value;
+    int oldValue = m_board.cells[row * GRID_SIZE + col];
+    assignCell(row * GRID_SIZE + col, value);
     
     emit valueChanged(row, col, value, oldValue);
     emit gridChanged();
@@ -121,51 +109,86 @@ bool SudokuGrid::isValidValue(int row, int col, int value) const
         return false;
     }
     
-    return !hasConflict(row, col, value);
+    return !hasConflict(row, col, value) && fitsSums(row * GRID_SIZE + col, value);
 }
 
+// The per-unit digit counts make each check a lookup per unit of the cell;
+// the cell's own value is discounted so it never conflicts with itself.
 bool SudokuGrid::hasConflict(int row, int col, int value) const
 {
-    return hasRowConflict(row, col, value) ||
-           hasColumnConflict(row, col, value) ||
-           hasBlockConflict(row, col, value);
+    int index = row * GRID_SIZE + col;
+    int self = (m_board.cells[index] == value) ? 1 : 0;
+    const quint16* units = m_graph.cellUnits(index);
+    int unitCount = m_graph.cellUnitCount(index);
+    
+    for (int u = 0; u < unitCount; ++u) {
+        if (digitCount(units[u], value) > self) {
+            return true;
+        }
+    }
+    return false;
 }
 
 QVector<QPoint> SudokuGrid::getConflicts(int row, int col, int value) const
 {
     QVector<QPoint> conflicts;
     
-    if (!isValidPosition(row, col) || value < 1 || value > 9) {
+    if (!isValidPosition(row, col) || value < 1 || value > 9 || !hasConflict(row, col, value)) {
         return conflicts;
     }
     
-    // Check row conflicts
-    for (int c = 0; c < GRID_SIZE; ++c) {
-        if (c != col && m_grid[row][c] == value) {
-            conflicts.append(QPoint(row, c));
+    // Row, then column, then region, then variant units; a cell sharing two
+    // units is listed twice
+    int index = row * GRID_SIZE + col;
+    const quint16* units = m_graph.cellUnits(index);
+    int unitCount = m_graph.cellUnitCount(index);
+    for (int u = 0; u < unitCount; ++u) {
+        int unit = units[u];
+        if (digitCount(unit, value) == 0) continue;
+        
+        const quint8* cells = m_graph.unitCells(unit);
+        int size = m_graph.unitSize(unit);
+        for (int i = 0; i < size; ++i) {
+            int other = cells[i];
+            if (other != index && m_board.cells[other] == value) {
+                conflicts.append(QPoint(other / GRID_SIZE, other % GRID_SIZE));
+            }
         }
     }
     
-    // Check column conflicts
-    for (int r = 0; r < GRID_SIZE; ++r) {
-        if (r != row && m_grid[r][col] == value) {
-            conflicts.append(QPoint(r, col));
-        }
+    return conflicts;
+}
+
+bool SudokuGrid::isConflicting(int row, int col) const
+{
+    if (!isValidPosition(row, col)) {
+        return false;
     }
     
-    // Check block conflicts
-    int blockStartRow = (row / BLOCK_SIZE) * BLOCK_SIZE;
-    int blockStartCol = (col / BLOCK_SIZE) * BLOCK_SIZE;
-    
-    for (int r = blockStartRow; r < blockStartRow + BLOCK_SIZE; ++r) {
-        for (int c = blockStartCol; c < blockStartCol + BLOCK_SIZE; ++c) {
-            if ((r != row || c != col) && m_grid[r][c] == value) {
-                conflicts.append(QPoint(r, c));
-            }
+    int index = row * GRID_SIZE + col;
+    return (m_conflicts[index >> 6] >> (index & 63)) & 1;
+}
+
+QVector<QPoint> SudokuGrid::getConflictingCells() const
+{
+    QVector<QPoint> cells;
+    cells.reserve(m_conflictCount);
+    
+    for (int word = 0; word < 2; ++word) {
+        quint64 bits = m_conflicts[word];
+        while (bits) {
+            int index = word * 64 + qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+            cells.append(QPoint(index / GRID_SIZE, index % GRID_SIZE));
         }
     }
     
-    return conflicts;
+    return cells;
+}
+
+int SudokuGrid::getConflictCount() const
+{
+    return m_conflictCount;
 }
 
 bool SudokuGrid::isRowValid(int row) const
@@ -174,17 +197,7 @@ bool SudokuGrid::isRowValid(int row) const
         return false;
     }
     
-    QSet<int> seen;
-    for (int col = 0; col < GRID_SIZE; ++col) {
-        int value = m_grid[row][col];
-        if (value != 0) {
-            if (seen.contains(value)) {
-                return false; // Duplicate found
-            }
-            seen.insert(value);
-        }
-    }
-    return true;
+    return m_duplicates[row] == 0;
 }
 
 bool SudokuGrid::isColumnValid(int col) const
@@ -193,17 +206,7 @@ bool SudokuGrid::isColumnValid(int col) const
         return false;
     }
     
-    QSet<int> seen;
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        int value = m_grid[row][col];
-        if (value != 0) {
-            if (seen.contains(value)) {
-                return false; // Duplicate found
-            }
-            seen.insert(value);
-        }
-    }
-    return true;
+    return m_duplicates[GRID_SIZE + col] == 0;
 }
 
 bool SudokuGrid::isBlockValid(int blockRow, int blockCol) const
@@ -212,36 +215,57 @@ bool SudokuGrid::isBlockValid(int blockRow, int blockCol) const
         return false;
     }
     
-    QSet<int> seen;
-    int startRow = blockRow * BLOCK_SIZE;
-    int startCol = blockCol * BLOCK_SIZE;
+    int unit = ConstraintGraph::REGION_UNIT + blockRow * BLOCK_SIZE + blockCol;
+    return m_duplicates[unit] == 0 && !m_sumBroken[unit];
+}
+
+quint16 SudokuGrid::getCandidateMask(int row, int col) const
+{
+    if (!isValidPosition(row, col)) {
+        return 0;
+    }
+    
+    int index = row * GRID_SIZE + col;
+    if (m_board.cells[index] != 0) {
+        return 0;
+    }
     
-    for (int row = startRow; row < startRow + BLOCK_SIZE; ++row) {
-        for (int col = startCol; col < startCol + BLOCK_SIZE; ++col) {
-            int value = m_grid[row][col];
-            if (value != 0) {
-                if (seen.contains(value)) {
-                    return false; // Duplicate found
-                }
-                seen.insert(value);
-            }
+    const quint16* units = m_graph.cellUnits(index);
+    int unitCount = m_graph.cellUnitCount(index);
+    quint16 used = 0;
+    for (int u = 0; u < unitCount; ++u) {
+        used |= m_unitMasks[units[u]];
+    }
+    
+    quint16 mask = quint16(~used & SudokuBoard::ALL_DIGITS);
+    for (int u = 0; u < unitCount && mask; ++u) {
+        int unit = units[u];
+        if (m_graph.sum(unit) != 0) {
+            // Digits the cage's empty cells could still add up to its sum with
+            int remaining = m_graph.sum(unit) - m_unitSums[unit];
+            int empty = m_graph.unitSize(unit) - m_unitFilled[unit];
+            quint16 unused = quint16(~m_unitMasks[unit] & SudokuBoard::ALL_DIGITS);
+            mask &= ConstraintGraph::sumDigits(empty, remaining, unused);
         }
     }
-    return true;
+    return mask;
+}
+
+int SudokuGrid::getCandidateCount(int row, int col) const
+{
+    return qPopulationCount(getCandidateMask(row, col));
 }
 
 QVector<int> SudokuGrid::getValidValues(int row, int col) const
 {
     QVector<int> validValues;
     
-    if (!isValidPosition(row, col) || m_grid[row][col] != 0) {
-        return validValues; // Cell is not empty
-    }
+    quint16 mask = getCandidateMask(row, col);
+    validValues.reserve(qPopulationCount(mask));
     
-    for (int value = 1; value <= 9; ++value) {
-        if (isValidValue(row, col, value)) {
-            validValues.append(value);
-        }
+    while (mask) {
+        validValues.append(qCountTrailingZeroBits(mask) + 1);
+        mask &= mask - 1;
     }
     
     return validValues;
@@ -250,10 +274,11 @@ QVector<int> SudokuGrid::getValidValues(int row, int col) const
 QVector<QPoint> SudokuGrid::getEmptyCells() const
 {
     QVector<QPoint> emptyCells;
+    emptyCells.reserve(getEmptyCount());
     
     for (int row = 0; row < GRID_SIZE; ++row) {
         for (int col = 0; col < GRID_SIZE; ++col) {
-            if (m_grid[row][col] == 0) {
+            if (m_board.cells[row * GRID_SIZE + col] == 0) {
                 emptyCells.append(QPoint(row, col));
             }
         }
@@ -264,15 +289,7 @@ QVector<QPoint> SudokuGrid::getEmptyCells() const
 
 int SudokuGrid::getEmptyCount() const
 {
-    int count = 0;
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (m_grid[row][col] == 0) {
-                count++;
-            }
-        }
-    }
-    return count;
+    return CELL_COUNT - m_filledCount;
 }
 
 int SudokuGrid::getBlockIndex(int row, int col) const
@@ -281,7 +298,8 @@ int SudokuGrid::getBlockIndex(int row, int col) const
         return -1;
     }
     
-    return (row / BLOCK_SIZE) * 3 + (col / BLOCK_SIZE);
+    // Units of a cell come rows first, so the third is its region
+    return m_graph.cellUnits(row * GRID_SIZE + col)[2] - ConstraintGraph::REGION_UNIT;
 }
 
 QPoint SudokuGrid::getBlockStartPosition(int blockIndex) const
@@ -299,16 +317,14 @@ QPoint SudokuGrid::getBlockStartPosition(int blockIndex) const
 QVector<QPoint> SudokuGrid::getBlockCells(int blockIndex) const
 {
     QVector<QPoint> cells;
-    QPoint startPos = getBlockStartPosition(blockIndex);
-    
-    if (startPos.x() == -1) {
+    if (blockIndex < 0 || blockIndex >= GRID_SIZE) {
         return cells;
     }
     
-    for (int row = startPos.x(); row < startPos.x() + BLOCK_SIZE; ++row) {
-        for (int col = startPos.y(); col < startPos.y() + BLOCK_SIZE; ++col) {
-            cells.append(QPoint(row, col));
-        }
+    const quint8* blockCells = m_graph.unitCells(ConstraintGraph::REGION_UNIT + blockIndex);
+    cells.reserve(GRID_SIZE);
+    for (int i = 0; i < GRID_SIZE; ++i) {
+        cells.append(QPoint(blockCells[i] / GRID_SIZE, blockCells[i] % GRID_SIZE));
     }
     
     return cells;
@@ -317,10 +333,8 @@ QVector<QPoint> SudokuGrid::getBlockCells(int blockIndex) const
 QString SudokuGrid::toString() const
 {
     QString result;
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            result += QString::number(m_grid[row][col]);
-        }
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        result += QString::number(m_board.cells[index]);
     }
     return result;
 }
@@ -332,17 +346,13 @@ void SudokuGrid::fromString(const QString& gridString)
         return;
     }
     
-    int index = 0;
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            QChar ch = gridString[index];
-            int value = ch.digitValue();
-            if (value >= 0 && value <= 9) {
-                m_grid[row][col] = value;
-            } else {
-                m_grid[row][col] = 0;
-            }
-            index++;
+    initializeGrid();
+    
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        QChar ch = gridString[index];
+        int value = ch.digitValue();
+        if (value > 0 && value <= 9) {
+            assignCell(index, value);
         }
     }
     
@@ -352,7 +362,17 @@ void SudokuGrid::fromString(const QString& gridString)
 SudokuGrid* SudokuGrid::copy() const
 {
     SudokuGrid* newGrid = new SudokuGrid;
-    newGrid->m_grid = m_grid;
+    newGrid->m_graph = m_graph;
+    newGrid->m_board = m_board;
+    newGrid->m_digitCount = m_digitCount;
+    newGrid->m_unitMasks = m_unitMasks;
+    newGrid->m_duplicates = m_duplicates;
+    newGrid->m_unitSums = m_unitSums;
+    newGrid->m_unitFilled = m_unitFilled;
+    newGrid->m_sumBroken = m_sumBroken;
+    std::memcpy(newGrid->m_conflicts, m_conflicts, sizeof(m_conflicts));
+    newGrid->m_conflictCount = m_conflictCount;
+    newGrid->m_filledCount = m_filledCount;
     return newGrid;
 }
 
@@ -362,55 +382,181 @@ bool SudokuGrid::equals(const SudokuGrid* other) const
         return false;
     }
     
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
-            if (m_grid[row][col] != other->m_grid[row][col]) {
-                return false;
-            }
+    return std::memcmp(m_board.cells, other->m_board.cells, sizeof(m_board.cells)) == 0;
+}
+
+SudokuBoard SudokuGrid::toBoard() const
+{
+    // Classic row, column and block masks for the solvers
+    SudokuBoard board;
+    board.clear();
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        if (m_board.cells[index] != 0) {
+            board.place(index / GRID_SIZE, index % GRID_SIZE, m_board.cells[index]);
         }
     }
+    return board;
+}
+
+void SudokuGrid::setBoard(const SudokuBoard& board)
+{
+    initializeGrid();
     
-    return true;
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        if (board.cells[index] != 0) {
+            assignCell(index, board.cells[index]);
+        }
+    }
+    
+    // One notification for the whole board instead of one per cell
+    emit gridChanged();
 }
 
 // Private helper methods
 
-bool SudokuGrid::isValidPosition(int row, int col) const
+void SudokuGrid::assignCell(int index, int value)
 {
-    return row >= 0 && row < GRID_SIZE && col >= 0 && col < GRID_SIZE;
+    int oldValue = m_board.cells[index];
+    if (oldValue == value) {
+        return;
+    }
+    
+    m_board.cells[index] = static_cast<quint8>(value);
+    const quint16* units = m_graph.cellUnits(index);
+    int unitCount = m_graph.cellUnitCount(index);
+    
+    if (oldValue != 0) {
+        m_filledCount--;
+        for (int u = 0; u < unitCount; ++u) {
+            removeDigit(units[u], oldValue);
+        }
+    }
+    
+    if (value != 0) {
+        m_filledCount++;
+        for (int u = 0; u < unitCount; ++u) {
+            addDigit(units[u], value);
+        }
+    }
+    
+    if (!m_graph.sumUnits().isEmpty()) {
+        for (int u = 0; u < unitCount; ++u) {
+            updateSum(units[u]);
+        }
+    }
+    
+    updateConflict(index);
 }
 
-bool SudokuGrid::hasRowConflict(int row, int col, int value) const
+// Conflicts only change for the holders of a digit when its count in a unit
+// crosses between one and two, so edits stay O(units of the cell) apart from
+// those cells.
+
+void SudokuGrid::addDigit(int unit, int value)
 {
-    for (int c = 0; c < GRID_SIZE; ++c) {
-        if (c != col && m_grid[row][c] == value) {
-            return true;
+    quint16 bit = SudokuBoard::digitBit(value);
+    int count = ++digitCount(unit, value);
+    m_unitSums[unit] += value;
+    m_unitFilled[unit]++;
+    
+    if (count == 1) {
+        m_unitMasks[unit] |= bit;
+    } else if (count == 2) {
+        m_duplicates[unit] |= bit;
+        updateConflicts(unit, value);
+    }
+}
+
+void SudokuGrid::removeDigit(int unit, int value)
+{
+    quint16 bit = SudokuBoard::digitBit(value);
+    int count = --digitCount(unit, value);
+    m_unitSums[unit] -= value;
+    m_unitFilled[unit]--;
+    
+    if (count == 0) {
+        m_unitMasks[unit] &= ~bit;
+    } else if (count == 1) {
+        m_duplicates[unit] &= ~bit;
+        updateConflicts(unit, value);
+    }
+}
+
+// A cage breaks its sum when its digits overshoot it, or add up to something
+// else once every cell is filled; its filled cells then conflict
+void SudokuGrid::updateSum(int unit)
+{
+    int sum = m_graph.sum(unit);
+    if (sum == 0) {
+        return;
+    }
+    
+    bool broken = m_unitSums[unit] > sum ||
+                  (m_unitFilled[unit] == m_graph.unitSize(unit) && m_unitSums[unit] != sum);
+    if (broken == m_sumBroken[unit]) {
+        return;
+    }
+    
+    m_sumBroken[unit] = broken;
+    const quint8* cells = m_graph.unitCells(unit);
+    for (int i = 0; i < m_graph.unitSize(unit); ++i) {
+        updateConflict(cells[i]);
+    }
+}
+
+void SudokuGrid::updateConflict(int index)
+{
+    int value = m_board.cells[index];
+    bool conflicting = false;
+    if (value != 0) {
+        const quint16* units = m_graph.cellUnits(index);
+        int unitCount = m_graph.cellUnitCount(index);
+        for (int u = 0; u < unitCount && !conflicting; ++u) {
+            conflicting = digitCount(units[u], value) > 1 || m_sumBroken[units[u]];
         }
     }
-    return false;
+    
+    quint64 bit = quint64(1) << (index & 63);
+    bool wasConflicting = (m_conflicts[index >> 6] & bit) != 0;
+    if (conflicting != wasConflicting) {
+        m_conflicts[index >> 6] ^= bit;
+        m_conflictCount += conflicting ? 1 : -1;
+    }
 }
 
-bool SudokuGrid::hasColumnConflict(int row, int col, int value) const
+void SudokuGrid::updateConflicts(int unit, int value)
 {
-    for (int r = 0; r < GRID_SIZE; ++r) {
-        if (r != row && m_grid[r][col] == value) {
-            return true;
+    const quint8* cells = m_graph.unitCells(unit);
+    int size = m_graph.unitSize(unit);
+    for (int i = 0; i < size; ++i) {
+        if (m_board.cells[cells[i]] == value) {
+            updateConflict(cells[i]);
         }
     }
-    return false;
 }
 
-bool SudokuGrid::hasBlockConflict(int row, int col, int value) const
+bool SudokuGrid::isValidPosition(int row, int col) const
 {
-    int blockStartRow = (row / BLOCK_SIZE) * BLOCK_SIZE;
-    int blockStartCol = (col / BLOCK_SIZE) * BLOCK_SIZE;
-    
-    for (int r = blockStartRow; r < blockStartRow + BLOCK_SIZE; ++r) {
-        for (int c = blockStartCol; c < blockStartCol + BLOCK_SIZE; ++c) {
-            if ((r != row || c != col) && m_grid[r][c] == value) {
-                return true;
-            }
+    return row >= 0 && row < GRID_SIZE && col >= 0 && col < GRID_SIZE;
+}
+
+// Whether the cages of a cell could still reach their sums with value in it
+bool SudokuGrid::fitsSums(int index, int value) const
+{
+    int oldValue = m_board.cells[index];
+    const quint16* units = m_graph.cellUnits(index);
+    int unitCount = m_graph.cellUnitCount(index);
+    
+    for (int u = 0; u < unitCount; ++u) {
+        int unit = units[u];
+        int sum = m_graph.sum(unit);
+        if (sum == 0) continue;
+        
+        int total = m_unitSums[unit] - oldValue + value;
+        int filled = m_unitFilled[unit] + (oldValue == 0 ? 1 : 0);
+        if (total > sum || (filled == m_graph.unitSize(unit) && total != sum)) {
+            return false;
         }
     }
-    return false;
-}
\ No newline at end of file
+    return true;
+}
@@ -5,6 +5,9 @@
 #include <QVector>
 #include <QString>
 #include <QPoint>
+#include <QtGlobal>
+#include "SudokuBoard.h"
+#include "ConstraintGraph.h"
 
 class SudokuGrid : public QObject
 {
@@ -13,7 +16,13 @@ class SudokuGrid : public QObject
 public:
     explicit SudokuGrid(QObject *parent = nullptr);
     
-    // Grid state management
+    // Constraints the grid is checked against, classic by default. Setting a
+    // variant keeps the values and recounts conflicts under the new rules.
+    void setConstraintGraph(const ConstraintGraph& graph);
+    const ConstraintGraph& constraintGraph() const;
+    
+    // Grid state management; the checks read counters kept up to date by
+    // every edit, so each is O(1)
     void reset();
     bool isValid() const;
     bool isSolved() const;
@@ -27,22 +36,36 @@ public:
     void clearCell(int row, int col);
     void clearAll();
     
-    // Validation methods
+    // Validation methods. hasConflict() and getConflicts() look at peers
+    // holding the same digit; isValidValue() also keeps cage sums reachable.
     bool isValidValue(int row, int col, int value) const;
     bool hasConflict(int row, int col, int value) const;
     QVector<QPoint> getConflicts(int row, int col, int value) const;
     
-    // Constraint checking
+    // Cells whose digit appears more than once in one of their units, or that
+    // sit in a cage whose digits overshoot or miss its sum, for highlighting.
+    // Tracked as cells change, so reading it never rescans.
+    bool isConflicting(int row, int col) const;
+    QVector<QPoint> getConflictingCells() const;
+    int getConflictCount() const;
+    
+    // Constraint checking; blocks are the regions of a jigsaw graph
     bool isRowValid(int row) const;
     bool isColumnValid(int col) const;
     bool isBlockValid(int blockRow, int blockCol) const;
     
+    // Candidate bitmasks (bit value-1 set when no peer holds value and the
+    // cages of the cell can still reach their sums with it)
+    quint16 getCandidateMask(int row, int col) const;
+    int getCandidateCount(int row, int col) const;
+    
     // Utility functions
     QVector<int> getValidValues(int row, int col) const;
     QVector<QPoint> getEmptyCells() const;
     int getEmptyCount() const;
     
-    // Block utilities
+    // Block utilities; getBlockIndex() and getBlockCells() follow the regions
+    // of the constraint graph, getBlockStartPosition() the 3x3 layout
     int getBlockIndex(int row, int col) const;
     QPoint getBlockStartPosition(int blockIndex) const;
     QVector<QPoint> getBlockCells(int blockIndex) const;
@@ -54,6 +77,10 @@ public:
     // Grid state
     SudokuGrid* copy() const;
     bool equals(const SudokuGrid* other) const;
+    
+    // Plain value snapshot for solver internals; setBoard() emits gridChanged() once
+    SudokuBoard toBoard() const;
+    void setBoard(const SudokuBoard& board);
 
 signals:
     void valueChanged(int row, int col, int newValue, int oldValue);
@@ -61,15 +88,41 @@ signals:
 
 private:
     void initializeGrid();
+    void assignCell(int index, int value);
+    void addDigit(int unit, int value);
+    void removeDigit(int unit, int value);
+    void updateSum(int unit);
+    void updateConflict(int index);
+    void updateConflicts(int unit, int value);
+    quint8& digitCount(int unit, int value) { return m_digitCount[unit * (GRID_SIZE + 1) + value]; }
+    int digitCount(int unit, int value) const { return m_digitCount[unit * (GRID_SIZE + 1) + value]; }
     bool isValidPosition(int row, int col) const;
-    bool hasRowConflict(int row, int col, int value) const;
-    bool hasColumnConflict(int row, int col, int value) const;
-    bool hasBlockConflict(int row, int col, int value) const;
+    bool fitsSums(int index, int value) const;
 
 private:
-    QVector<QVector<int>> m_grid;  // 9x9 grid, 0 = empty
     static constexpr int GRID_SIZE = 9;
     static constexpr int BLOCK_SIZE = 3;
+    static constexpr int CELL_COUNT = GRID_SIZE * GRID_SIZE;
+    
+    ConstraintGraph m_graph;
+    
+    // Cell values; the masks are rebuilt by toBoard()
+    SudokuBoard m_board;
+    
+    // Per unit of the graph: how many cells hold each digit (GRID_SIZE + 1
+    // entries per unit), the digits present, the digits held more than once,
+    // and the digit sum and filled cells for checking cage sums
+    QVector<quint8> m_digitCount;
+    QVector<quint16> m_unitMasks;
+    QVector<quint16> m_duplicates;
+    QVector<quint8> m_unitSums;
+    QVector<quint8> m_unitFilled;
+    QVector<bool> m_sumBroken;
+    
+    // Cells in conflict, one bit per cell, and how many there are
+    quint64 m_conflicts[2];
+    int m_conflictCount;
+    int m_filledCount;
 };
 
 #endif // SUDOKUGRID_H
\ No newline at end of file
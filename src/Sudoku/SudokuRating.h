@@ -0,0 +1,15 @@
+#ifndef SUDOKURATING_H
+#define SUDOKURATING_H
+
+// SE-style difficulty of a puzzle, from SudokuSolver::rate(). Ratings are
+// kept in tenths, so 23 stands for the 2.3 of a naked single.
+struct SudokuRating {
+    int rating = 0;         // Hardest step the solve needed
+    int pearl = 0;          // Hardest step up to and including the first placement
+    int diamond = 0;        // The first step
+    int steps = 0;          // Deductions applied
+    bool solved = false;    // False when the techniques stalled, or with all ratings 0 when
+                            // the puzzle turned out to have no solution
+};
+
+#endif // SUDOKURATING_H
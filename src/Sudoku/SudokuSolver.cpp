@@ -1,34 +1,407 @@
 #include "SudokuSolver.h"
 #include "SudokuGrid.h"
+#include "DancingLinks.h"
+#include "ConstrainedSearch.h"
+#include "VariantSearch.h"
+#include "ConstraintGraph.h"
+#include "SolveCache.h"
+#include "CandidateKernel.h"
+#include "LaneSolver.h"
+#include "SudokuGenerator.h"
 #include <QDebug>
 #include <QtGlobal>
 #include <QSet>
+#include <QtAlgorithms>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QRandomGenerator>
+#include <limits>
+#include <cstring>
+
+namespace {
+
+// Fewer givens never pin down a unique solution, and near-empty boards are the
+// slowest to canonicalize, so such puzzles bypass the solve cache
+const int MIN_CACHED_GIVENS = 17;
+
+int givenCount(const SudokuBoard& board)
+{
+    int count = 0;
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        if (board.cells[cell] != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Cells filled by a recorded solve
+int placementCount(const QVector<SolutionStep>& steps)
+{
+    int count = 0;
+    for (const SolutionStep& step : steps) {
+        if (step.value != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Loads, solves and writes back a puzzle of one compile-time size
+template<int BOX>
+bool solveSized(QVector<int>& values, SolveCounters& counters)
+{
+    typedef BasicSudokuBoard<BOX> Board;
+    if (values.size() != Board::CELL_COUNT) {
+        return false;
+    }
+    
+    Board board;
+    board.clear();
+    for (int cell = 0; cell < Board::CELL_COUNT; ++cell) {
+        int value = values[cell];
+        if (value == 0) continue;
+        
+        int row = cell / Board::GRID_SIZE;
+        int col = cell % Board::GRID_SIZE;
+        if (value < 0 || value > Board::GRID_SIZE || !board.canPlace(row, col, value)) {
+            return false;
+        }
+        board.place(row, col, value);
+    }
+    
+    BasicConstrainedSearch<BOX> search;
+    bool solved = search.load(board) && search.solve(1) > 0;
+    counters.nodes = search.nodesVisited();
+    counters.peakDepth = search.peakDepth();
+    counters.propagations += search.propagations();
+    if (solved) {
+        for (int cell = 0; cell < Board::CELL_COUNT; ++cell) {
+            values[cell] = search.solution().cells[cell];
+        }
+    }
+    return solved;
+}
+
+// Expands the search tree breadth-first, branching on the cell with the fewest
+// candidates, until there are enough independent subtrees to keep every worker
+// busy. Boards completed during the expansion are counted as solutions and,
+// when completed is given, collected there.
+void splitSearch(const SudokuBoard& root, int targetCount, int maxSolutions,
+                 QVector<SudokuBoard>& frontier, int& solutionCount,
+                 QVector<SudokuBoard>* completed = nullptr)
+{
+    frontier.clear();
+    frontier.append(root);
+    
+    QVector<SudokuBoard> next;
+    while (frontier.size() < targetCount && solutionCount < maxSolutions) {
+        next.clear();
+        
+        for (const SudokuBoard& board : frontier) {
+            int bestCell = -1;
+            int bestCount = 10;
+            for (int cell = 0; cell < SudokuBoard::CELL_COUNT && bestCount > 1; ++cell) {
+                if (board.cells[cell] != 0) continue;
+                int count = qPopulationCount(board.candidateMask(cell / 9, cell % 9));
+                if (count < bestCount) {
+                    bestCell = cell;
+                    bestCount = count;
+                }
+            }
+            
+            if (bestCell == -1) {
+                if (board.isComplete()) {
+                    solutionCount++;
+                    if (completed) {
+                        completed->append(board);
+                    }
+                }
+                continue;
+            }
+            
+            quint16 candidates = board.candidateMask(bestCell / 9, bestCell % 9);
+            while (candidates) {
+                int value = qCountTrailingZeroBits(candidates) + 1;
+                candidates &= candidates - 1;
+                
+                next.append(board);
+                next.last().place(bestCell / 9, bestCell % 9, value);
+            }
+        }
+        
+        frontier.swap(next);
+        if (frontier.isEmpty()) {
+            break;
+        }
+    }
+}
+
+// Row-major backtracking count that stops as soon as the shared count is reached
+void backtrackCount(SudokuBoard& board, int start, int maxSolutions,
+                    QAtomicInt& solutionCount, QAtomicInt& nodeCount)
+{
+    nodeCount.fetchAndAddRelaxed(1);
+    
+    int cell = start;
+    while (cell < SudokuBoard::CELL_COUNT && board.cells[cell] != 0) {
+        cell++;
+    }
+    
+    if (cell == SudokuBoard::CELL_COUNT) {
+        solutionCount.fetchAndAddOrdered(1);
+        return;
+    }
+    
+    int row = cell / 9;
+    int col = cell % 9;
+    quint16 candidates = board.candidateMask(row, col);
+    while (candidates) {
+        int value = qCountTrailingZeroBits(candidates) + 1;
+        candidates &= candidates - 1;
+        
+        board.place(row, col, value);
+        backtrackCount(board, cell + 1, maxSolutions, solutionCount, nodeCount);
+        board.erase(row, col);
+        
+        if (solutionCount.loadAcquire() >= maxSolutions) return;
+    }
+}
+
+// Counts the solutions below one subtree of a parallel search
+struct SubtreeCounter {
+    SolveMode mode;
+    int maxSolutions;
+    QAtomicInt* solutionCount;
+    QAtomicInt* nodeCount;
+    
+    void operator()(const SudokuBoard& subtree) const
+    {
+        if (solutionCount->loadAcquire() >= maxSolutions) {
+            return; // Cancelled before this task started
+        }
+        
+        if (mode == SolveMode::DancingLinks) {
+            DancingLinks dlx;
+            dlx.setSharedCount(solutionCount);
+            if (dlx.load(subtree)) {
+                dlx.solve(maxSolutions);
+            }
+            nodeCount->fetchAndAddRelaxed(dlx.nodesVisited());
+        } else if (mode == SolveMode::MostConstrained) {
+            ConstrainedSearch search;
+            search.setSharedCount(solutionCount);
+            if (search.load(subtree)) {
+                search.solve(maxSolutions);
+            }
+            nodeCount->fetchAndAddRelaxed(search.nodesVisited());
+        } else {
+            SudokuBoard board = subtree;
+            backtrackCount(board, 0, maxSolutions, *solutionCount, *nodeCount);
+        }
+    }
+};
+
+// Enumerates or counts the solutions below one subtree of a parallel search
+struct SubtreeEnumerator {
+    const ConstrainedSearch::Visitor* visitor;
+    QAtomicInt* stop;
+    QAtomicInteger<qint64>* solutionCount;
+    QAtomicInteger<qint64>* nodeCount;
+    QAtomicInteger<qint64>* propagationCount;
+    QAtomicInt* peakDepth;                  // Deepest subtree search, below the split
+    
+    void operator()(const SudokuBoard& subtree) const
+    {
+        if (stop->loadAcquire() != 0) {
+            return;
+        }
+        
+        ConstrainedSearch search;
+        search.setVisitor(visitor);
+        search.setStopFlag(stop);
+        if (search.load(subtree)) {
+            solutionCount->fetchAndAddRelaxed(search.solve(std::numeric_limits<qint64>::max()));
+        }
+        nodeCount->fetchAndAddRelaxed(search.nodesVisited());
+        propagationCount->fetchAndAddRelaxed(search.propagations());
+        
+        int depth = search.peakDepth();
+        int current = peakDepth->loadAcquire();
+        while (depth > current && !peakDepth->testAndSetRelaxed(current, depth)) {
+            current = peakDepth->loadAcquire();
+        }
+    }
+};
+
+// Places of every digit in every unit: places[digit][unit] has bit i set
+// while the i-th cell of the unit can take the digit. Built in one pass over
+// the pencil marks, so fish and chains test a unit with a single load.
+struct DigitPlaces {
+    quint16 places[SudokuBoard::GRID_SIZE][SudokuUnits::UNIT_COUNT];
+    
+    explicit DigitPlaces(const CandidateGrid& grid)
+    {
+        std::memset(places, 0, sizeof(places));
+        for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+            int row = cell / 9;
+            int col = cell % 9;
+            int index = (row % 3) * 3 + col % 3;
+            const quint8* units = SudokuUnits::units(cell);
+            
+            quint16 candidates = grid.candidates[cell];
+            while (candidates) {
+                int digit = qCountTrailingZeroBits(candidates);
+                candidates &= candidates - 1;
+                places[digit][units[0]] |= 1u << col;
+                places[digit][units[1]] |= 1u << row;
+                places[digit][units[2]] |= 1u << index;
+            }
+        }
+    }
+    
+    // The other place of a digit in a unit where it has exactly two, else -1
+    int partner(int digit, int unit, int cell) const
+    {
+        quint16 bits = places[digit][unit];
+        if (qPopulationCount(bits) != 2) {
+            return -1;
+        }
+        const quint8* cells = SudokuUnits::cells(unit);
+        int first = cells[qCountTrailingZeroBits(bits)];
+        int second = cells[qCountTrailingZeroBits(quint16(bits & (bits - 1)))];
+        return first == cell ? second : first;
+    }
+};
+
+// First unit two cells share, or -1
+int sharedUnit(int cell, int other)
+{
+    const quint8* units = SudokuUnits::units(cell);
+    const quint8* otherUnits = SudokuUnits::units(other);
+    for (int i = 0; i < 3; ++i) {
+        if (units[i] == otherUnits[i]) {
+            return units[i];
+        }
+    }
+    return -1;
+}
+
+bool sees(int cell, int other)
+{
+    return cell != other && sharedUnit(cell, other) >= 0;
+}
+
+// Source lines of a set of canonical rows (kindUnit 0) or columns (kindUnit 9);
+// under transposition the whole set turns into the other kind
+quint16 sourceLines(quint16 lines, int kindUnit, const SudokuTransform& transform)
+{
+    quint16 mapped = 0;
+    while (lines) {
+        int line = qCountTrailingZeroBits(lines);
+        lines &= lines - 1;
+        mapped |= 1u << (transform.sourceUnit(kindUnit + line) % 9);
+    }
+    return mapped;
+}
+
+} // namespace
 
 SudokuSolver::SudokuSolver(QObject *parent)
     : QObject(parent)
     , m_solutionCount(0)
     , m_backtrackCount(0)
     , m_maxDepth(0)
+    , m_statistics(techniqueNames())
+    , m_solveNesting(0)
+    , m_solveMode(SolveMode::Backtracking)
     , m_useLogicalTechniques(true)
-    , m_explainSteps(true)
+    , m_recordSteps(true)
+    , m_singleDeduction(false)
+    , m_useCache(true)
     , m_maxSolutions(2) // For uniqueness checking
+    , m_monitor(nullptr)
 {
     // Initialize technique order (easiest first)
-    m_techniqueOrder << "naked_singles" << "hidden_singles" << "naked_pairs" << "pointing_pairs" << "box_line_reduction";
+    m_techniqueOrder << "naked_singles" << "hidden_singles" << "naked_pairs" << "pointing_pairs" << "box_line_reduction"
+                     << "x_wings" << "swordfish" << "xy_wings" << "xyz_wings" << "simple_colouring" << "jellyfish"
+                     << "x_chains" << "alternating_chains";
     
-    // Set difficulty ratings for techniques
-    m_techniqueDifficulty["naked_singles"] = 1;
-    m_techniqueDifficulty["hidden_singles"] = 2;
-    m_techniqueDifficulty["naked_pairs"] = 3;
-    m_techniqueDifficulty["pointing_pairs"] = 4;
-    m_techniqueDifficulty["box_line_reduction"] = 5;
-    m_techniqueDifficulty["backtrack"] = 10;
+    m_solveTimer.start();
 }
 
 SudokuSolver::~SudokuSolver()
 {
 }
 
+void SudokuSolver::setSolveMode(SolveMode mode)
+{
+    m_solveMode = mode;
+}
+
+SolveMode SudokuSolver::solveMode() const
+{
+    return m_solveMode;
+}
+
+void SudokuSolver::setCacheEnabled(bool enabled)
+{
+    m_useCache = enabled;
+}
+
+int SudokuSolver::searchNodes() const
+{
+    return m_backtrackCount;
+}
+
+const SolveCounters& SudokuSolver::lastSolveCounters() const
+{
+    return m_counters;
+}
+
+const SolverStatistics& SudokuSolver::statistics() const
+{
+    return m_statistics;
+}
+
+void SudokuSolver::resetStatistics()
+{
+    m_statistics.clear();
+}
+
+QStringList SudokuSolver::techniqueNames()
+{
+    QStringList names;
+    for (int technique = 0; technique < STEP_TECHNIQUE_COUNT; ++technique) {
+        names << techniqueName(StepTechnique(technique));
+    }
+    return names;
+}
+
+void SudokuSolver::beginSolve()
+{
+    if (m_solveNesting++ == 0) {
+        m_counters = SolveCounters();
+        m_counters.wallTimeNs = m_solveTimer.nsecsElapsed();
+        m_maxDepth = 0;
+    }
+}
+
+void SudokuSolver::endSolve(bool solved)
+{
+    if (--m_solveNesting > 0) {
+        return;
+    }
+    
+    m_counters.wallTimeNs = m_solveTimer.nsecsElapsed() - m_counters.wallTimeNs;
+    m_counters.nodes = m_backtrackCount;
+    m_counters.peakDepth = m_maxDepth;
+    m_counters.solved = solved;
+    m_statistics.record(m_counters);
+}
+
 bool SudokuSolver::solve(SudokuGrid* grid)
 {
     if (!grid || !grid->isValid()) {
@@ -41,51 +414,276 @@ bool SudokuSolver::solve(SudokuGrid* grid)
         return true;
     }
     
-    // Create a working copy
-    SudokuGrid* workingGrid = copyGrid(grid);
+    // Work on a plain value copy; the grid itself is written once at the end
+    const ConstraintGraph& graph = grid->constraintGraph();
+    SudokuBoard board = grid->toBoard();
+    bool solved = graph.isClassic() ? solveWithCache(board) : solve(board, graph);
     
+    if (solved) {
+        grid->setBoard(board);
+        qDebug() << "SudokuSolver: Solved. Search nodes:" << m_backtrackCount;
+    } else {
+        qDebug() << "SudokuSolver: No solution found";
+    }
+    
+    return solved;
+}
+
+bool SudokuSolver::solveWithCache(SudokuBoard& board)
+{
+    beginSolve();
+    bool solved;
+    
+    if (m_useCache && givenCount(board) >= MIN_CACHED_GIVENS) {
+        // Isomorphic puzzles share one cache entry in canonical form
+        SudokuTransform transform;
+        SudokuBoard canonical = SudokuCanonical::canonicalize(board, transform);
+        QByteArray key = SudokuCanonical::key(canonical);
+        
+        SudokuBoard solution;
+        if (SolveCache::global().findSolution(key, solved, solution)) {
+            m_solutionCount = solved ? 1 : 0;
+            m_backtrackCount = 0;
+            m_maxDepth = 0;
+        } else {
+            solution = canonical;
+            solved = solve(solution);
+            if (!searchStopped()) {
+                SolveCache::global().insertSolution(key, solved, solution);
+            }
+        }
+        
+        if (solved) {
+            board = transform.toSource(solution);
+        }
+    } else {
+        solved = solve(board);
+    }
+    
+    endSolve(solved);
+    return solved;
+}
+
+bool SudokuSolver::solve(SudokuBoard& board)
+{
+    beginSolve();
+    bool solved = searchBoard(board);
+    endSolve(solved);
+    return solved;
+}
+
+bool SudokuSolver::solve(SudokuBoard& board, const ConstraintGraph& graph)
+{
+    if (graph.isClassic()) {
+        return solve(board);
+    }
+    
+    beginSolve();
+    VariantSearch search(graph);
+    search.setMonitor(m_monitor);
+    bool solved = search.load(board) && search.solve(1) > 0;
+    m_solutionCount = solved ? 1 : 0;
+    m_backtrackCount = search.nodesVisited();
+    m_maxDepth = search.peakDepth();
+    m_counters.propagations += search.propagations();
+    if (solved) {
+        board = search.solution();
+    }
+    endSolve(solved);
+    return solved;
+}
+
+qint64 SudokuSolver::countSolutions(const SudokuBoard& board, const ConstraintGraph& graph, qint64 limit)
+{
+    beginSolve();
+    VariantSearch search(graph);
+    search.setMonitor(m_monitor);
+    qint64 count = search.load(board) ? search.solve(limit) : 0;
+    m_solutionCount = int(qMin<qint64>(count, std::numeric_limits<int>::max()));
+    m_backtrackCount = search.nodesVisited();
+    m_maxDepth = search.peakDepth();
+    m_counters.propagations += search.propagations();
+    endSolve(count > 0);
+    return count;
+}
+
+bool SudokuSolver::searchBoard(SudokuBoard& board)
+{
     // Reset statistics
     m_solutionCount = 0;
     m_backtrackCount = 0;
     m_maxDepth = 0;
     
-    // Try logical techniques first
+    if (board.isComplete()) {
+        return true;
+    }
+    
+    if (m_solveMode == SolveMode::DancingLinks) {
+        return dancingLinksSolve(board);
+    }
+    
+    if (m_solveMode == SolveMode::MostConstrained) {
+        return constrainedSolve(board);
+    }
+    
+    // Try logical techniques first, without recording steps
     QVector<SolutionStep> steps;
+    m_recordSteps = false;
     if (m_useLogicalTechniques) {
-        while (applySolvingTechniques(workingGrid, steps)) {
-            if (workingGrid->isSolved()) {
-                // Copy solution back to original grid
-                for (int row = 0; row < 9; ++row) {
-                    for (int col = 0; col < 9; ++col) {
-                        grid->setValue(row, col, workingGrid->getValue(row, col));
-                    }
-                }
-                delete workingGrid;
-                qDebug() << "SudokuSolver: Solved using logical techniques with" << steps.size() << "steps";
+        CandidateGrid grid;
+        grid.load(board);
+        while (applySolvingTechniques(grid, steps)) {
+            if (grid.isComplete()) {
+                board = grid.board;
                 return true;
             }
         }
+        board = grid.board;
     }
     
     // Fall back to backtracking
-    bool solved = backtrackSolve(workingGrid, 0, 0);
+    return backtrackSolve(board);
+}
+
+bool SudokuSolver::solve(QVector<int>& values, int boxSize)
+{
+    m_solutionCount = 0;
+    m_backtrackCount = 0;
+    m_maxDepth = 0;
+    beginSolve();
     
-    if (solved) {
-        // Copy solution back to original grid
-        for (int row = 0; row < 9; ++row) {
-            for (int col = 0; col < 9; ++col) {
-                grid->setValue(row, col, workingGrid->getValue(row, col));
+    bool solved = false;
+    switch (boxSize) {
+    case 2:
+        solved = solveSized<2>(values, m_counters);
+        break;
+    case 3:
+        solved = solveSized<3>(values, m_counters);
+        break;
+    case 4:
+        solved = solveSized<4>(values, m_counters);
+        break;
+    case 5:
+        solved = solveSized<5>(values, m_counters);
+        break;
+    default:
+        qDebug() << "SudokuSolver: Unsupported box size" << boxSize;
+        break;
+    }
+    
+    m_backtrackCount = int(m_counters.nodes);
+    m_maxDepth = m_counters.peakDepth;
+    m_solutionCount = solved ? 1 : 0;
+    endSolve(solved);
+    return solved;
+}
+
+QVector<bool> SudokuSolver::solveBatch(QVector<SudokuBoard>& boards)
+{
+    QVector<bool> solved(boards.size(), false);
+    SudokuBoard* data = boards.data();
+    LaneSolver::Outcome outcomes[LaneSolver::LANE_COUNT];
+    
+    for (int first = 0; first < boards.size(); first += LaneSolver::LANE_COUNT) {
+        int count = qMin(LaneSolver::LANE_COUNT, boards.size() - first);
+        LaneSolver::propagate(data + first, outcomes, count);
+        
+        for (int lane = 0; lane < count; ++lane) {
+            if (outcomes[lane] == LaneSolver::Outcome::Solved) {
+                solved[first + lane] = true;
+            } else if (outcomes[lane] == LaneSolver::Outcome::NeedsSearch) {
+                solved[first + lane] = solve(data[first + lane]);
             }
         }
-        qDebug() << "SudokuSolver: Solved using backtracking. Backtracks:" << m_backtrackCount;
-    } else {
-        qDebug() << "SudokuSolver: No solution found";
     }
     
-    delete workingGrid;
     return solved;
 }
 
+QFuture<SolveResult> SudokuSolver::solveAsync(const SudokuBoard& board, const CancellationToken& token,
+                                              QDeadlineTimer deadline)
+{
+    return runAsync(board, ConstraintGraph(), token, deadline, false);
+}
+
+QFuture<SolveResult> SudokuSolver::solveAsync(const SudokuBoard& board, const ConstraintGraph& graph,
+                                              const CancellationToken& token, QDeadlineTimer deadline)
+{
+    return runAsync(board, graph, token, deadline, false);
+}
+
+QFuture<SolveResult> SudokuSolver::solveWithStepsAsync(const SudokuBoard& board, const CancellationToken& token,
+                                                       QDeadlineTimer deadline)
+{
+    return runAsync(board, ConstraintGraph(), token, deadline, true);
+}
+
+QFuture<SolveResult> SudokuSolver::runAsync(const SudokuBoard& board, const ConstraintGraph& graph,
+                                            const CancellationToken& token, QDeadlineTimer deadline,
+                                            bool withSteps)
+{
+    SolveMode mode = m_solveMode;
+    bool useLogic = m_useLogicalTechniques;
+    bool useCache = m_useCache;
+    
+    return QtConcurrent::run([this, board, graph, token, deadline, withSteps, mode, useLogic, useCache]() {
+        // The worker gets a solver of its own, so this one's state is never
+        // touched from two threads
+        SudokuSolver solver;
+        solver.m_solveMode = mode;
+        solver.m_useLogicalTechniques = useLogic;
+        solver.m_useCache = useCache;
+        
+        SearchMonitor monitor(token, deadline, [this](qint64 nodes, int depth) {
+            emit solveProgress(nodes, depth);
+        });
+        solver.m_monitor = &monitor;
+        
+        SolveResult result;
+        result.board = board;
+        bool solved;
+        
+        if (withSteps) {
+            solver.m_recordSteps = true;
+            solver.solveWithSteps(board, result.steps);
+            
+            // A finished search leaves one placement per empty cell on the steps.
+            // A stopped one ends inside a guess branch, so the puzzle is returned.
+            SudokuBoard filled = board;
+            for (const SolutionStep& step : result.steps) {
+                if (step.technique == StepTechnique::NakedSingle ||
+                    step.technique == StepTechnique::HiddenSingle ||
+                    step.technique == StepTechnique::BacktrackGuess) {
+                    filled.place(step.row, step.col, step.value);
+                }
+            }
+            solved = !monitor.stopped() && filled.isComplete();
+            if (solved) {
+                result.board = filled;
+            }
+        } else {
+            SudokuBoard solution = board;
+            solved = graph.isClassic() ? solver.solveWithCache(solution) : solver.solve(solution, graph);
+            if (solved) {
+                result.board = solution;
+            }
+        }
+        
+        if (solved) {
+            result.status = SolveStatus::Solved;
+        } else if (monitor.reason() == StopReason::Cancelled) {
+            result.status = SolveStatus::Cancelled;
+        } else if (monitor.reason() == StopReason::DeadlineExpired) {
+            result.status = SolveStatus::TimedOut;
+        } else {
+            result.status = SolveStatus::Unsolvable;
+        }
+        result.nodes = monitor.nodes();
+        result.peakDepth = monitor.peakDepth();
+        return result;
+    });
+}
+
 QVector<SolutionStep> SudokuSolver::solveWithSteps(SudokuGrid* grid)
 {
     QVector<SolutionStep> steps;
@@ -97,305 +695,983 @@ QVector<SolutionStep> SudokuSolver::solveWithSteps(SudokuGrid* grid)
     
     if (grid->isSolved()) {
         SolutionStep step;
-        step.row = -1;
-        step.col = -1;
-        step.value = 0;
-        step.reason = "Grid is already solved!";
-        step.technique = "validation";
+        step.technique = StepTechnique::AlreadySolved;
         steps.append(step);
         return steps;
     }
     
-    // Create a working copy
-    SudokuGrid* workingGrid = copyGrid(grid);
+    // The techniques reason about rows, columns and blocks only
+    if (!grid->constraintGraph().isClassic()) {
+        qDebug() << "SudokuSolver: Step solving needs a classic grid";
+        return steps;
+    }
     
-    // Apply logical techniques with step recording
-    bool progress = true;
-    int iteration = 0;
-    const int maxIterations = 100; // Prevent infinite loops
+    m_recordSteps = true;
+    solveWithSteps(grid->toBoard(), steps);
+    return steps;
+}
+
+void SudokuSolver::solveWithSteps(const SudokuBoard& board, QVector<SolutionStep>& steps)
+{
+    beginSolve();
+    int givens = givenCount(board);
+    if (!m_useCache || givens < MIN_CACHED_GIVENS) {
+        CandidateGrid candidates;
+        candidates.load(board);
+        endSolve(solveWithSteps(candidates, steps));
+        return;
+    }
     
-    while (progress && !workingGrid->isSolved() && iteration < maxIterations) {
-        progress = false;
-        int stepsBefore = steps.size();
+    // Steps are recorded and cached in canonical form, then mapped back
+    SudokuTransform transform;
+    SudokuBoard canonical = SudokuCanonical::canonicalize(board, transform);
+    QByteArray key = SudokuCanonical::key(canonical);
+    
+    QVector<SolutionStep> canonicalSteps;
+    bool solved;
+    if (SolveCache::global().findSteps(key, canonicalSteps)) {
+        m_backtrackCount = 0;
+        m_maxDepth = 0;
+        solved = givens + placementCount(canonicalSteps) == SudokuBoard::CELL_COUNT;
+    } else {
+        CandidateGrid candidates;
+        candidates.load(canonical);
+        solved = solveWithSteps(candidates, canonicalSteps);
+        if (!searchStopped()) {
+            SolveCache::global().insertSteps(key, canonicalSteps);
+        }
+    }
+    
+    steps.reserve(steps.size() + canonicalSteps.size());
+    for (const SolutionStep& step : canonicalSteps) {
+        steps.append(stepToSource(step, transform));
+    }
+    endSolve(solved);
+}
+
+bool SudokuSolver::solveWithSteps(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    // An open guess remembers how far to roll the grid and the steps back
+    struct Guess {
+        int cell;
+        int value;
+        int trailMark;
+        int stepCount;
+    };
+    
+    // Both live on the stack; a path fills at most 81 cells and removes at most 729 marks
+    CandidateTrail trail;
+    Guess guesses[SudokuBoard::CELL_COUNT];
+    int depth = 0;
+    grid.trail = &trail;
+    m_backtrackCount = 0;
+    m_maxDepth = 0;
+    
+    // Most puzzles take about one step per empty cell
+    if (steps.capacity() < steps.size() + grid.emptyCount) {
+        steps.reserve(steps.size() + grid.emptyCount);
+        m_counters.stepBufferGrowths++;
+    }
+    
+    while (true) {
+        if (m_monitor && m_monitor->poll(depth)) {
+            break;
+        }
         
-        // Try each technique in order
-        if (applyNakedSingles(workingGrid, steps)) progress = true;
-        else if (applyHiddenSingles(workingGrid, steps)) progress = true;
-        else if (applyNakedPairs(workingGrid, steps)) progress = true;
-        else if (applyPointingPairs(workingGrid, steps)) progress = true;
-        else if (applyBoxLineReduction(workingGrid, steps)) progress = true;
+        // Apply logical techniques with step recording until they stall
+        bool contradiction = grid.hasContradiction();
+        bool progress = true;
+        while (progress && !contradiction && !grid.isComplete()) {
+            // Try each technique in order
+            progress = runTechnique(StepTechnique::NakedSingle, grid, steps) ||
+                       runTechnique(StepTechnique::HiddenSingle, grid, steps) ||
+                       runTechnique(StepTechnique::NakedPair, grid, steps) ||
+                       runTechnique(StepTechnique::PointingPair, grid, steps) ||
+                       runTechnique(StepTechnique::BoxLineReduction, grid, steps) ||
+                       runTechnique(StepTechnique::XWing, grid, steps) ||
+                       runTechnique(StepTechnique::Swordfish, grid, steps) ||
+                       runTechnique(StepTechnique::XYWing, grid, steps) ||
+                       runTechnique(StepTechnique::XYZWing, grid, steps) ||
+                       runTechnique(StepTechnique::SimpleColouring, grid, steps) ||
+                       runTechnique(StepTechnique::Jellyfish, grid, steps) ||
+                       runTechnique(StepTechnique::XChain, grid, steps) ||
+                       runTechnique(StepTechnique::AlternatingChain, grid, steps);
+            contradiction = grid.hasContradiction();
+        }
+        
+        if (!contradiction && grid.isComplete()) {
+            break;
+        }
         
-        if (steps.size() == stepsBefore) {
-            progress = false; // No new steps added
+        if (contradiction) {
+            if (depth == 0) {
+                break; // No guess left to take back: the puzzle has no solution
+            }
+            
+            // The latest guess was wrong; undo everything it led to and rule its value out
+            const Guess& guess = guesses[--depth];
+            grid.undo(guess.trailMark);
+            steps.resize(guess.stepCount);
+            m_backtrackCount++;
+            
+            SolutionStep pattern;
+            pattern.technique = StepTechnique::Contradiction;
+            eliminateCandidates(grid, guess.cell, SudokuBoard::digitBit(guess.value), pattern, steps);
+            continue;
+        }
+        
+        // Logic stalled: guess on the cell with the fewest candidates
+        int cell = -1;
+        int fewest = 10;
+        for (int i = 0; i < SudokuBoard::CELL_COUNT && fewest > 2; ++i) {
+            int count = qPopulationCount(grid.candidates[i]);
+            if (count > 0 && count < fewest) {
+                cell = i;
+                fewest = count;
+            }
         }
         
-        iteration++;
+        int row = cell / 9;
+        int col = cell % 9;
+        int value = qCountTrailingZeroBits(grid.candidates[cell]) + 1;
+        
+        Guess& guess = guesses[depth++];
+        guess.cell = cell;
+        guess.value = value;
+        guess.trailMark = trail.size;
+        guess.stepCount = steps.size();
+        m_maxDepth = qMax(m_maxDepth, depth);
+        
+        grid.place(row, col, value);
+        
+        if (m_recordSteps) {
+            SolutionStep step;
+            step.row = row;
+            step.col = col;
+            step.value = value;
+            step.technique = StepTechnique::BacktrackGuess;
+            steps.append(step);
+        }
     }
     
-    // If not solved with logical techniques, use guided backtracking
-    if (!workingGrid->isSolved()) {
-        QPoint nextCell = findNextEmptyCell(workingGrid);
-        if (nextCell.x() != -1) {
-            QVector<int> candidates = getCandidates(workingGrid, nextCell.x(), nextCell.y());
+    grid.trail = nullptr;
+    return grid.isComplete() && !grid.hasContradiction();
+}
+
+bool SudokuSolver::backtrackSolve(SudokuBoard& board, int depth)
+{
+    m_backtrackCount++;
+    m_maxDepth = qMax(m_maxDepth, depth);
+    if (m_monitor && m_monitor->poll(depth)) {
+        return false;
+    }
+    
+    // One kernel pass gives every cell's candidates and spots dead ends early
+    quint16 candidates[CandidateKernel::PADDED_CELLS];
+    CandidateSummary summary = CandidateKernel::compute(board, candidates);
+    if (summary.contradiction) {
+        return false;
+    }
+    
+    // Branch on a naked single when there is one, otherwise on the first empty cell
+    int cell = -1;
+    if (summary.singles[0]) {
+        cell = qCountTrailingZeroBits(summary.singles[0]);
+        m_counters.propagations++;
+    } else if (summary.singles[1]) {
+        cell = 64 + qCountTrailingZeroBits(summary.singles[1]);
+        m_counters.propagations++;
+    } else {
+        QPoint nextCell = findNextEmptyCell(board);
+        if (nextCell.x() == -1) {
+            return board.isComplete(); // No empty cells left
+        }
+        cell = nextCell.x() * 9 + nextCell.y();
+    }
+    
+    int cellRow = cell / 9;
+    int cellCol = cell % 9;
+    
+    // Try each possible value straight from the candidate bitmask
+    quint16 mask = candidates[cell];
+    while (mask) {
+        int value = qCountTrailingZeroBits(mask) + 1;
+        mask &= mask - 1;
+        
+        board.place(cellRow, cellCol, value);
+        
+        if (backtrackSolve(board, depth + 1)) {
+            return true;
+        }
+        
+        // Backtrack
+        board.erase(cellRow, cellCol);
+    }
+    
+    return false;
+}
+
+QPoint SudokuSolver::findNextEmptyCell(const SudokuBoard& board, int startRow, int startCol)
+{
+    for (int row = startRow; row < 9; ++row) {
+        int colStart = (row == startRow) ? startCol : 0;
+        for (int col = colStart; col < 9; ++col) {
+            if (board.value(row, col) == 0) {
+                return QPoint(row, col);
+            }
+        }
+    }
+    return QPoint(-1, -1); // No empty cell found
+}
+
+bool SudokuSolver::applySolvingTechniques(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    bool progress = false;
+    
+    // Try techniques in order of difficulty
+    for (const QString& technique : m_techniqueOrder) {
+        if (technique == "naked_singles") {
+            if (runTechnique(StepTechnique::NakedSingle, grid, steps)) progress = true;
+        } else if (technique == "hidden_singles") {
+            if (runTechnique(StepTechnique::HiddenSingle, grid, steps)) progress = true;
+        } else if (technique == "naked_pairs") {
+            if (runTechnique(StepTechnique::NakedPair, grid, steps)) progress = true;
+        } else if (technique == "pointing_pairs") {
+            if (runTechnique(StepTechnique::PointingPair, grid, steps)) progress = true;
+        } else if (technique == "box_line_reduction") {
+            if (runTechnique(StepTechnique::BoxLineReduction, grid, steps)) progress = true;
+        } else if (technique == "x_wings") {
+            if (runTechnique(StepTechnique::XWing, grid, steps)) progress = true;
+        } else if (technique == "swordfish") {
+            if (runTechnique(StepTechnique::Swordfish, grid, steps)) progress = true;
+        } else if (technique == "jellyfish") {
+            if (runTechnique(StepTechnique::Jellyfish, grid, steps)) progress = true;
+        } else if (technique == "xy_wings") {
+            if (runTechnique(StepTechnique::XYWing, grid, steps)) progress = true;
+        } else if (technique == "xyz_wings") {
+            if (runTechnique(StepTechnique::XYZWing, grid, steps)) progress = true;
+        } else if (technique == "simple_colouring") {
+            if (runTechnique(StepTechnique::SimpleColouring, grid, steps)) progress = true;
+        } else if (technique == "x_chains") {
+            if (runTechnique(StepTechnique::XChain, grid, steps)) progress = true;
+        } else if (technique == "alternating_chains") {
+            if (runTechnique(StepTechnique::AlternatingChain, grid, steps)) progress = true;
+        }
+        
+        if (progress) break; // Apply one technique at a time
+    }
+    
+    return progress;
+}
+
+bool SudokuSolver::runTechnique(StepTechnique technique, CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    int emptyBefore = grid.emptyCount;
+    int capacityBefore = steps.capacity();
+    qint64 start = m_solveTimer.nsecsElapsed();
+    
+    bool progress = false;
+    switch (technique) {
+    case StepTechnique::NakedSingle:
+        progress = applyNakedSingles(grid, steps);
+        break;
+    case StepTechnique::HiddenSingle:
+        progress = applyHiddenSingles(grid, steps);
+        break;
+    case StepTechnique::NakedPair:
+        progress = applyNakedPairs(grid, steps);
+        break;
+    case StepTechnique::PointingPair:
+        progress = applyPointingPairs(grid, steps);
+        break;
+    case StepTechnique::BoxLineReduction:
+        progress = applyBoxLineReduction(grid, steps);
+        break;
+    case StepTechnique::XWing:
+        progress = applyFish(grid, steps, 2);
+        break;
+    case StepTechnique::Swordfish:
+        progress = applyFish(grid, steps, 3);
+        break;
+    case StepTechnique::Jellyfish:
+        progress = applyFish(grid, steps, 4);
+        break;
+    case StepTechnique::XYWing:
+        progress = applyXYWings(grid, steps);
+        break;
+    case StepTechnique::XYZWing:
+        progress = applyXYZWings(grid, steps);
+        break;
+    case StepTechnique::SimpleColouring:
+        progress = applySimpleColouring(grid, steps);
+        break;
+    case StepTechnique::XChain:
+        progress = applyChains(grid, steps, false);
+        break;
+    case StepTechnique::AlternatingChain:
+        progress = applyChains(grid, steps, true);
+        break;
+    default:
+        break;
+    }
+    
+    m_counters.addTechnique(int(technique), progress, m_solveTimer.nsecsElapsed() - start);
+    m_counters.propagations += emptyBefore - grid.emptyCount;
+    if (steps.capacity() != capacityBefore) {
+        m_counters.stepBufferGrowths++;
+    }
+    return progress;
+}
+
+bool SudokuSolver::applyNakedSingles(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    bool progress = false;
+    CandidateSummary summary = CandidateKernel::summarize(grid.board, grid.candidates);
+    
+    for (int word = 0; word < 2; ++word) {
+        quint64 singles = summary.singles[word];
+        while (singles) {
+            int cell = word * 64 + qCountTrailingZeroBits(singles);
+            singles &= singles - 1;
             
-            if (!candidates.isEmpty()) {
-                // For demonstration, just take the first candidate
-                int value = candidates.first();
-                workingGrid->setValue(nextCell.x(), nextCell.y(), value);
-                
+            // An earlier placement in this pass may have taken the last pencil mark
+            quint16 candidates = grid.candidates[cell];
+            if (candidates == 0 || (candidates & (candidates - 1)) != 0) {
+                continue;
+            }
+            
+            int row = cell / 9;
+            int col = cell % 9;
+            int value = qCountTrailingZeroBits(candidates) + 1;
+            grid.place(row, col, value);
+            
+            if (m_recordSteps) {
                 SolutionStep step;
-                step.row = nextCell.x();
-                step.col = nextCell.y();
+                step.row = row;
+                step.col = col;
                 step.value = value;
-                step.reason = QString("Trying candidate %1 at position (%2,%3). If this leads to a contradiction, we'll backtrack.")
-                             .arg(value).arg(nextCell.x() + 1).arg(nextCell.y() + 1);
-                step.technique = "backtrack_guess";
+                step.technique = StepTechnique::NakedSingle;
                 steps.append(step);
-                
-                // Continue with logical techniques
-                QVector<SolutionStep> remainingSteps = solveWithSteps(workingGrid);
-                steps.append(remainingSteps);
             }
+            
+            if (m_singleDeduction) {
+                return true;
+            }
+            progress = true;
         }
     }
     
-    delete workingGrid;
-    return steps;
+    return progress;
 }
 
-bool SudokuSolver::backtrackSolve(SudokuGrid* grid, int row, int col)
+bool SudokuSolver::applyHiddenSingles(CandidateGrid& grid, QVector<SolutionStep>& steps)
 {
-    m_backtrackCount++;
+    bool progress = false;
     
-    // Find next empty cell
-    QPoint nextCell = findNextEmptyCell(grid, row, col);
-    if (nextCell.x() == -1) {
-        return grid->isSolved(); // No empty cells left
+    // Units 0-8 are rows, 9-17 columns and 18-26 blocks; blocks go first,
+    // as block singles are the easiest to spot
+    for (int order = 0; order < SudokuUnits::UNIT_COUNT; ++order) {
+        int unit = (order + 18) % SudokuUnits::UNIT_COUNT;
+        const quint8* cells = SudokuUnits::cells(unit);
+        
+        // Digits seen in exactly one cell's pencil marks
+        quint16 once = 0;
+        quint16 twice = 0;
+        for (int i = 0; i < 9; ++i) {
+            quint16 candidates = grid.candidates[cells[i]];
+            twice |= once & candidates;
+            once |= candidates;
+        }
+        quint16 hidden = once & ~twice;
+        
+        while (hidden) {
+            int value = qCountTrailingZeroBits(hidden) + 1;
+            quint16 bit = SudokuBoard::digitBit(value);
+            hidden &= hidden - 1;
+            
+            for (int i = 0; i < 9; ++i) {
+                int cell = cells[i];
+                // An earlier placement may have taken this cell or the digit
+                if (!(grid.candidates[cell] & bit)) continue;
+                
+                int row = cell / 9;
+                int col = cell % 9;
+                grid.place(row, col, value);
+                
+                if (m_recordSteps) {
+                    SolutionStep step;
+                    step.row = row;
+                    step.col = col;
+                    step.value = value;
+                    step.technique = StepTechnique::HiddenSingle;
+                    step.unit = unit;
+                    steps.append(step);
+                }
+                
+                if (m_singleDeduction) {
+                    return true;
+                }
+                progress = true;
+                break;
+            }
+        }
     }
     
-    int cellRow = nextCell.x();
-    int cellCol = nextCell.y();
+    return progress;
+}
+
+bool SudokuSolver::applyNakedPairs(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    for (int unit = 0; unit < 27; ++unit) {
+        const quint8* cells = SudokuUnits::cells(unit);
+        
+        for (int i = 0; i < 9; ++i) {
+            quint16 pair = grid.candidates[cells[i]];
+            if (qPopulationCount(pair) != 2) continue;
+            
+            for (int j = i + 1; j < 9; ++j) {
+                if (grid.candidates[cells[j]] != pair) continue;
+                
+                // The two digits are locked into these cells; no other cell of the unit can take them
+                SolutionStep pattern;
+                pattern.technique = StepTechnique::NakedPair;
+                pattern.unit = unit;
+                pattern.pairCells[0] = cells[i];
+                pattern.pairCells[1] = cells[j];
+                pattern.digits = pair;
+                
+                bool progress = false;
+                for (int k = 0; k < 9; ++k) {
+                    if (k == i || k == j) continue;
+                    progress |= eliminateCandidates(grid, cells[k], pair, pattern, steps);
+                }
+                
+                if (progress) {
+                    return true;
+                }
+            }
+        }
+    }
     
-    // Try each possible value
-    for (int value = 1; value <= 9; ++value) {
-        if (grid->isValidValue(cellRow, cellCol, value)) {
-            grid->setValue(cellRow, cellCol, value);
+    return false;
+}
+
+bool SudokuSolver::applyPointingPairs(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    for (int block = 0; block < 9; ++block) {
+        const quint8* cells = SudokuUnits::cells(18 + block);
+        
+        for (int value = 1; value <= 9; ++value) {
+            quint16 bit = SudokuBoard::digitBit(value);
+            quint16 rows = 0;
+            quint16 cols = 0;
+            for (int i = 0; i < 9; ++i) {
+                if (grid.candidates[cells[i]] & bit) {
+                    rows |= 1u << SudokuUnits::rowUnit(cells[i]);
+                    cols |= 1u << (SudokuUnits::columnUnit(cells[i]) - 9);
+                }
+            }
+            
+            // The digit must go on one line inside the block, so the rest of that line loses it
+            int line;
+            if (rows != 0 && (rows & (rows - 1)) == 0) {
+                line = qCountTrailingZeroBits(rows);
+            } else if (cols != 0 && (cols & (cols - 1)) == 0) {
+                line = 9 + qCountTrailingZeroBits(cols);
+            } else {
+                continue;
+            }
             
-            if (backtrackSolve(grid, cellRow, cellCol)) {
+            const quint8* lineCells = SudokuUnits::cells(line);
+            
+            SolutionStep pattern;
+            pattern.technique = StepTechnique::PointingPair;
+            pattern.unit = 18 + block;
+            pattern.crossUnit = line;
+            pattern.digits = bit;
+            
+            bool progress = false;
+            for (int i = 0; i < 9; ++i) {
+                int cell = lineCells[i];
+                if (SudokuUnits::blockUnit(cell) == 18 + block) continue;
+                progress |= eliminateCandidates(grid, cell, bit, pattern, steps);
+            }
+            
+            if (progress) {
                 return true;
             }
+        }
+    }
+    
+    return false;
+}
+
+bool SudokuSolver::applyBoxLineReduction(CandidateGrid& grid, QVector<SolutionStep>& steps)
+{
+    for (int line = 0; line < 18; ++line) {
+        const quint8* cells = SudokuUnits::cells(line);
+        
+        for (int value = 1; value <= 9; ++value) {
+            quint16 bit = SudokuBoard::digitBit(value);
+            quint16 blocks = 0;
+            for (int i = 0; i < 9; ++i) {
+                if (grid.candidates[cells[i]] & bit) {
+                    blocks |= 1u << (SudokuUnits::blockUnit(cells[i]) - 18);
+                }
+            }
+            
+            // The digit must go inside one block on this line, so the rest of that block loses it
+            if (blocks == 0 || (blocks & (blocks - 1)) != 0) continue;
+            int block = qCountTrailingZeroBits(blocks);
+            
+            const quint8* blockCells = SudokuUnits::cells(18 + block);
+            
+            SolutionStep pattern;
+            pattern.technique = StepTechnique::BoxLineReduction;
+            pattern.unit = line;
+            pattern.crossUnit = 18 + block;
+            pattern.digits = bit;
+            
+            bool progress = false;
+            for (int i = 0; i < 9; ++i) {
+                int cell = blockCells[i];
+                bool onLine = SudokuUnits::rowUnit(cell) == line || SudokuUnits::columnUnit(cell) == line;
+                if (onLine) continue;
+                progress |= eliminateCandidates(grid, cell, bit, pattern, steps);
+            }
             
-            // Backtrack
-            grid->setValue(cellRow, cellCol, 0);
+            if (progress) {
+                return true;
+            }
         }
     }
     
     return false;
 }
 
-QPoint SudokuSolver::findNextEmptyCell(SudokuGrid* grid, int startRow, int startCol)
+// Fish: size base lines (rows or columns) that hold a digit only inside size
+// cover lines of the other kind. Every cover line gets the digit on one of the
+// base lines, so its other cells lose it. Size 2 is the X-Wing, 3 the
+// Swordfish and 4 the Jellyfish.
+bool SudokuSolver::applyFish(CandidateGrid& grid, QVector<SolutionStep>& steps, int size)
 {
-    for (int row = startRow; row < 9; ++row) {
-        int colStart = (row == startRow) ? startCol : 0;
-        for (int col = colStart; col < 9; ++col) {
-            if (grid->getValue(row, col) == 0) {
-                return QPoint(row, col);
+    static const StepTechnique techniques[5] = {
+        StepTechnique::AlreadySolved, StepTechnique::AlreadySolved,
+        StepTechnique::XWing, StepTechnique::Swordfish, StepTechnique::Jellyfish
+    };
+    
+    DigitPlaces places(grid);
+    
+    for (int digit = 0; digit < 9; ++digit) {
+        quint16 bit = quint16(1u << digit);
+        
+        for (int base = 0; base < 18; base += 9) {
+            int cover = 9 - base;
+            
+            // Lines with two to size places; a line with one is a hidden single
+            quint16 eligible = 0;
+            for (int line = 0; line < 9; ++line) {
+                int count = qPopulationCount(places.places[digit][base + line]);
+                if (count >= 2 && count <= size) {
+                    eligible |= 1u << line;
+                }
+            }
+            if (qPopulationCount(eligible) < uint(size)) continue;
+            
+            for (int baseSet = 1; baseSet < (1 << 9); ++baseSet) {
+                if ((baseSet & ~eligible) != 0 || qPopulationCount(quint16(baseSet)) != uint(size)) continue;
+                
+                quint16 coverSet = 0;
+                for (int lines = baseSet; lines; lines &= lines - 1) {
+                    coverSet |= places.places[digit][base + qCountTrailingZeroBits(quint16(lines))];
+                }
+                if (qPopulationCount(coverSet) != uint(size)) continue;
+                
+                SolutionStep pattern;
+                pattern.technique = techniques[size];
+                pattern.unit = base + qCountTrailingZeroBits(quint16(baseSet));
+                pattern.digits = bit;
+                pattern.baseSet = quint16(baseSet);
+                pattern.coverSet = coverSet;
+                
+                // Position i of a cover line lies on base line i
+                bool progress = false;
+                for (quint16 lines = coverSet; lines; lines &= lines - 1) {
+                    const quint8* cells = SudokuUnits::cells(cover + qCountTrailingZeroBits(lines));
+                    for (int i = 0; i < 9; ++i) {
+                        if (baseSet & (1 << i)) continue;
+                        progress |= eliminateCandidates(grid, cells[i], bit, pattern, steps);
+                    }
+                }
+                
+                if (progress) {
+                    return true;
+                }
             }
         }
     }
-    return QPoint(-1, -1); // No empty cell found
+    
+    return false;
 }
 
-bool SudokuSolver::applySolvingTechniques(SudokuGrid* grid, QVector<SolutionStep>& steps)
+// XY-Wing: a pivot holding x or y sees one wing holding x or z and another
+// holding y or z. Whichever digit the pivot takes leaves z in one wing, so
+// no cell seeing both wings can hold z.
+bool SudokuSolver::applyXYWings(CandidateGrid& grid, QVector<SolutionStep>& steps)
 {
-    bool progress = false;
-    
-    // Try techniques in order of difficulty
-    for (const QString& technique : m_techniqueOrder) {
-        if (technique == "naked_singles") {
-            if (applyNakedSingles(grid, steps)) progress = true;
-        } else if (technique == "hidden_singles") {
-            if (applyHiddenSingles(grid, steps)) progress = true;
-        } else if (technique == "naked_pairs") {
-            if (applyNakedPairs(grid, steps)) progress = true;
-        } else if (technique == "pointing_pairs") {
-            if (applyPointingPairs(grid, steps)) progress = true;
-        } else if (technique == "box_line_reduction") {
-            if (applyBoxLineReduction(grid, steps)) progress = true;
+    for (int pivot = 0; pivot < SudokuBoard::CELL_COUNT; ++pivot) {
+        quint16 xy = grid.candidates[pivot];
+        if (qPopulationCount(xy) != 2) continue;
+        
+        // Bivalue peers sharing one digit with the pivot
+        int wings[SudokuUnits::PEER_COUNT];
+        int wingCount = 0;
+        const quint8* peers = SudokuUnits::peers(pivot);
+        for (int i = 0; i < SudokuUnits::PEER_COUNT; ++i) {
+            quint16 candidates = grid.candidates[peers[i]];
+            if (qPopulationCount(candidates) == 2 && qPopulationCount(quint16(candidates & xy)) == 1) {
+                wings[wingCount++] = peers[i];
+            }
         }
         
-        if (progress) break; // Apply one technique at a time
+        for (int i = 0; i < wingCount; ++i) {
+            quint16 first = grid.candidates[wings[i]];
+            for (int j = i + 1; j < wingCount; ++j) {
+                quint16 second = grid.candidates[wings[j]];
+                
+                // One wing per pivot digit, both sharing z
+                quint16 z = first & second & ~xy;
+                if (z == 0 || (first & xy) == (second & xy)) continue;
+                
+                SolutionStep pattern;
+                pattern.technique = StepTechnique::XYWing;
+                pattern.pivot = pivot;
+                pattern.pairCells[0] = wings[i];
+                pattern.pairCells[1] = wings[j];
+                pattern.digits = z;
+                
+                bool progress = false;
+                const quint8* wingPeers = SudokuUnits::peers(wings[i]);
+                for (int k = 0; k < SudokuUnits::PEER_COUNT; ++k) {
+                    int cell = wingPeers[k];
+                    if (sees(cell, wings[j])) {
+                        progress |= eliminateCandidates(grid, cell, z, pattern, steps);
+                    }
+                }
+                
+                if (progress) {
+                    return true;
+                }
+            }
+        }
     }
     
-    return progress;
+    return false;
 }
 
-bool SudokuSolver::applyNakedSingles(SudokuGrid* grid, QVector<SolutionStep>& steps)
+// XYZ-Wing: a pivot holding x, y or z sees a wing holding x or z and one
+// holding y or z. One of the three holds z, so a cell seeing all of them
+// cannot.
+bool SudokuSolver::applyXYZWings(CandidateGrid& grid, QVector<SolutionStep>& steps)
 {
-    bool progress = false;
-    
-    for (int row = 0; row < 9; ++row) {
-        for (int col = 0; col < 9; ++col) {
-            if (grid->getValue(row, col) == 0) {
-                QVector<int> candidates = getCandidates(grid, row, col);
+    for (int pivot = 0; pivot < SudokuBoard::CELL_COUNT; ++pivot) {
+        quint16 xyz = grid.candidates[pivot];
+        if (qPopulationCount(xyz) != 3) continue;
+        
+        // Bivalue peers drawn from the pivot's digits
+        int wings[SudokuUnits::PEER_COUNT];
+        int wingCount = 0;
+        const quint8* peers = SudokuUnits::peers(pivot);
+        for (int i = 0; i < SudokuUnits::PEER_COUNT; ++i) {
+            quint16 candidates = grid.candidates[peers[i]];
+            if (qPopulationCount(candidates) == 2 && (candidates & ~xyz) == 0) {
+                wings[wingCount++] = peers[i];
+            }
+        }
+        
+        for (int i = 0; i < wingCount; ++i) {
+            quint16 first = grid.candidates[wings[i]];
+            for (int j = i + 1; j < wingCount; ++j) {
+                quint16 second = grid.candidates[wings[j]];
+                if (first == second || (first | second) != xyz) continue;
+                quint16 z = first & second;
                 
-                if (candidates.size() == 1) {
-                    int value = candidates.first();
-                    grid->setValue(row, col, value);
-                    
-                    if (m_explainSteps) {
-                        SolutionStep step;
-                        step.row = row;
-                        step.col = col;
-                        step.value = value;
-                        step.reason = explainNakedSingle(row, col, value, candidates);
-                        step.technique = "naked_single";
-                        steps.append(step);
+                SolutionStep pattern;
+                pattern.technique = StepTechnique::XYZWing;
+                pattern.pivot = pivot;
+                pattern.pairCells[0] = wings[i];
+                pattern.pairCells[1] = wings[j];
+                pattern.digits = z;
+                
+                // Only the pivot's own units can see the pivot and a wing
+                bool progress = false;
+                for (int k = 0; k < SudokuUnits::PEER_COUNT; ++k) {
+                    int cell = peers[k];
+                    if (sees(cell, wings[i]) && sees(cell, wings[j])) {
+                        progress |= eliminateCandidates(grid, cell, z, pattern, steps);
                     }
-                    
-                    progress = true;
+                }
+                
+                if (progress) {
+                    return true;
                 }
             }
         }
     }
     
-    return progress;
+    return false;
 }
 
-bool SudokuSolver::applyHiddenSingles(SudokuGrid* grid, QVector<SolutionStep>& steps)
+// Simple colouring: the conjugate pairs of a digit (units where it has just
+// two places) join cells into clusters coloured in alternation, and one colour
+// of a cluster holds the digit throughout. Two cells of one colour sharing a
+// unit rule that colour out (a wrap); a cell seeing both colours loses the
+// digit (a trap).
+bool SudokuSolver::applySimpleColouring(CandidateGrid& grid, QVector<SolutionStep>& steps)
 {
-    bool progress = false;
+    DigitPlaces places(grid);
     
-    // Check rows
-    for (int row = 0; row < 9; ++row) {
-        for (int value = 1; value <= 9; ++value) {
-            QVector<int> possibleCols;
+    for (int digit = 0; digit < 9; ++digit) {
+        quint16 bit = quint16(1u << digit);
+        
+        // Colour 2 * cluster + side, -1 while uncoloured
+        int colour[SudokuBoard::CELL_COUNT];
+        for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+            colour[cell] = -1;
+        }
+        int clusterCount = 0;
+        
+        for (int start = 0; start < SudokuBoard::CELL_COUNT; ++start) {
+            if (!(grid.candidates[start] & bit) || colour[start] >= 0) continue;
+            
+            // Colour the cluster breadth-first along conjugate pairs
+            int cluster[SudokuBoard::CELL_COUNT];
+            int size = 0;
+            int id = clusterCount++;
+            cluster[size++] = start;
+            colour[start] = 2 * id;
+            for (int next = 0; next < size; ++next) {
+                int cell = cluster[next];
+                const quint8* units = SudokuUnits::units(cell);
+                for (int i = 0; i < 3; ++i) {
+                    int other = places.partner(digit, units[i], cell);
+                    if (other >= 0 && colour[other] < 0) {
+                        colour[other] = colour[cell] ^ 1;
+                        cluster[size++] = other;
+                    }
+                }
+            }
+            
+            // A lone pair is left to the locked candidates
+            if (size < 3) continue;
             
-            for (int col = 0; col < 9; ++col) {
-                if (grid->getValue(row, col) == 0 && grid->isValidValue(row, col, value)) {
-                    possibleCols.append(col);
+            SolutionStep pattern;
+            pattern.technique = StepTechnique::SimpleColouring;
+            pattern.digits = bit;
+            
+            // Wrap: the colour of two cells in one unit is false everywhere
+            for (int i = 0; i < size; ++i) {
+                for (int j = i + 1; j < size; ++j) {
+                    if (colour[cluster[i]] != colour[cluster[j]] || !sees(cluster[i], cluster[j])) continue;
+                    
+                    pattern.pairCells[0] = cluster[i];
+                    pattern.pairCells[1] = cluster[j];
+                    pattern.crossUnit = sharedUnit(cluster[i], cluster[j]);
+                    
+                    bool progress = false;
+                    for (int k = 0; k < size; ++k) {
+                        if (colour[cluster[k]] == colour[cluster[i]]) {
+                            progress |= eliminateCandidates(grid, cluster[k], bit, pattern, steps);
+                        }
+                    }
+                    return progress;
                 }
             }
             
-            if (possibleCols.size() == 1) {
-                int col = possibleCols.first();
-                grid->setValue(row, col, value);
+            // Trap: a cell outside the cluster seeing a cell of each colour
+            for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+                if (!(grid.candidates[cell] & bit) || (colour[cell] >> 1) == id) continue;
                 
-                if (m_explainSteps) {
-                    SolutionStep step;
-                    step.row = row;
-                    step.col = col;
-                    step.value = value;
-                    step.reason = explainHiddenSingle(row, col, value, "row");
-                    step.technique = "hidden_single";
-                    steps.append(step);
+                int seen[2] = { -1, -1 };
+                for (int i = 0; i < size; ++i) {
+                    if (sees(cell, cluster[i])) {
+                        seen[colour[cluster[i]] & 1] = cluster[i];
+                    }
                 }
+                if (seen[0] < 0 || seen[1] < 0) continue;
                 
-                progress = true;
+                pattern.pairCells[0] = seen[0];
+                pattern.pairCells[1] = seen[1];
+                pattern.crossUnit = -1;
+                if (eliminateCandidates(grid, cell, bit, pattern, steps)) {
+                    return true;
+                }
             }
         }
     }
     
-    // Check columns
-    for (int col = 0; col < 9; ++col) {
-        for (int value = 1; value <= 9; ++value) {
-            QVector<int> possibleRows;
+    return false;
+}
+
+// Alternating inference chains over candidates (cell, digit). A strong link
+// joins two candidates that cannot both be false: the only two places of a
+// digit in a unit, or the two digits of a bivalue cell. A weak link joins two
+// that cannot both be true: one digit in two peers, or two digits of one cell.
+// If the first candidate of a chain that starts and ends on strong links and
+// alternates in between is false, the last is true, so one of the two ends
+// holds. X-chains stay on one digit; with crossDigits chains also pass
+// through cells.
+//
+// Chains are grown breadth-first from every candidate, so the shortest chain
+// to each end is found first. The state says whether a candidate was reached
+// as false (next link strong) or as true (next link weak).
+bool SudokuSolver::applyChains(CandidateGrid& grid, QVector<SolutionStep>& steps, bool crossDigits)
+{
+    static constexpr int NODE_COUNT = SudokuBoard::CELL_COUNT * 9;
+    
+    DigitPlaces places(grid);
+    qint16 length[NODE_COUNT * 2];
+    quint16 queue[NODE_COUNT * 2];
+    
+    for (int start = 0; start < NODE_COUNT; ++start) {
+        int startCell = start / 9;
+        int startDigit = start % 9;
+        if (!(grid.candidates[startCell] & (1u << startDigit))) continue;
+        
+        std::memset(length, -1, sizeof(length));
+        int head = 0;
+        int tail = 0;
+        length[start * 2] = 0;
+        queue[tail++] = quint16(start * 2);
+        
+        while (head < tail) {
+            int state = queue[head++];
+            int node = state / 2;
+            bool isTrue = state & 1;
+            int cell = node / 9;
+            int digit = node % 9;
+            int links = length[state] + 1;
             
-            for (int row = 0; row < 9; ++row) {
-                if (grid->getValue(row, col) == 0 && grid->isValidValue(row, col, value)) {
-                    possibleRows.append(row);
+            // Candidates the next link reaches
+            int next[SudokuUnits::PEER_COUNT + 9];
+            int nextCount = 0;
+            if (!isTrue) {
+                const quint8* units = SudokuUnits::units(cell);
+                for (int i = 0; i < 3; ++i) {
+                    int other = places.partner(digit, units[i], cell);
+                    if (other >= 0) {
+                        next[nextCount++] = other * 9 + digit;
+                    }
+                }
+                quint16 candidates = grid.candidates[cell];
+                if (crossDigits && qPopulationCount(candidates) == 2) {
+                    next[nextCount++] = cell * 9 + qCountTrailingZeroBits(quint16(candidates & ~(1u << digit)));
+                }
+            } else {
+                const quint8* peers = SudokuUnits::peers(cell);
+                for (int i = 0; i < SudokuUnits::PEER_COUNT; ++i) {
+                    if (grid.candidates[peers[i]] & (1u << digit)) {
+                        next[nextCount++] = peers[i] * 9 + digit;
+                    }
+                }
+                if (crossDigits) {
+                    quint16 others = grid.candidates[cell] & ~(1u << digit);
+                    while (others) {
+                        next[nextCount++] = cell * 9 + qCountTrailingZeroBits(others);
+                        others &= others - 1;
+                    }
                 }
             }
             
-            if (possibleRows.size() == 1) {
-                int row = possibleRows.first();
-                grid->setValue(row, col, value);
+            for (int i = 0; i < nextCount; ++i) {
+                int target = next[i] * 2 + (isTrue ? 0 : 1);
+                if (length[target] >= 0) continue;
+                length[target] = qint16(links);
+                queue[tail++] = quint16(target);
                 
-                if (m_explainSteps) {
-                    SolutionStep step;
-                    step.row = row;
-                    step.col = col;
-                    step.value = value;
-                    step.reason = explainHiddenSingle(row, col, value, "column");
-                    step.technique = "hidden_single";
-                    steps.append(step);
-                }
+                // A candidate reached as true closes a chain
+                int end = next[i];
+                if (isTrue || end == start || links < 3) continue;
                 
-                progress = true;
-            }
-        }
-    }
-    
-    // Check blocks
-    for (int blockRow = 0; blockRow < 3; ++blockRow) {
-        for (int blockCol = 0; blockCol < 3; ++blockCol) {
-            for (int value = 1; value <= 9; ++value) {
-                QVector<QPoint> possibleCells;
+                int endCell = end / 9;
+                int endDigit = end % 9;
+                quint16 startBit = quint16(1u << startDigit);
+                quint16 endBit = quint16(1u << endDigit);
+                
+                SolutionStep pattern;
+                pattern.technique = crossDigits ? StepTechnique::AlternatingChain : StepTechnique::XChain;
+                pattern.pairCells[0] = startCell;
+                pattern.pairCells[1] = endCell;
+                pattern.digits = startBit | endBit;
+                pattern.chainLength = quint8(qMin(links, 255));
+                pattern.endDigits[0] = quint8(startDigit + 1);
+                pattern.endDigits[1] = quint8(endDigit + 1);
                 
-                for (int r = blockRow * 3; r < (blockRow + 1) * 3; ++r) {
-                    for (int c = blockCol * 3; c < (blockCol + 1) * 3; ++c) {
-                        if (grid->getValue(r, c) == 0 && grid->isValidValue(r, c, value)) {
-                            possibleCells.append(QPoint(r, c));
+                bool progress = false;
+                if (startDigit == endDigit) {
+                    // Cells seeing both ends lose the digit
+                    const quint8* peers = SudokuUnits::peers(startCell);
+                    for (int k = 0; k < SudokuUnits::PEER_COUNT; ++k) {
+                        if (sees(peers[k], endCell)) {
+                            progress |= eliminateCandidates(grid, peers[k], startBit, pattern, steps);
                         }
                     }
+                } else if (startCell == endCell) {
+                    // The cell holds one of the two digits
+                    progress = eliminateCandidates(grid, startCell, quint16(~(startBit | endBit)), pattern, steps);
+                } else if (sees(startCell, endCell)) {
+                    // Each end's digit would make the other end false in its own cell
+                    progress |= eliminateCandidates(grid, startCell, endBit, pattern, steps);
+                    progress |= eliminateCandidates(grid, endCell, startBit, pattern, steps);
                 }
                 
-                if (possibleCells.size() == 1) {
-                    QPoint cell = possibleCells.first();
-                    grid->setValue(cell.x(), cell.y(), value);
-                    
-                    if (m_explainSteps) {
-                        SolutionStep step;
-                        step.row = cell.x();
-                        step.col = cell.y();
-                        step.value = value;
-                        step.reason = explainHiddenSingle(cell.x(), cell.y(), value, "block");
-                        step.technique = "hidden_single";
-                        steps.append(step);
-                    }
-                    
-                    progress = true;
+                if (progress) {
+                    return true;
                 }
             }
         }
     }
     
-    return progress;
-}
-
-bool SudokuSolver::applyNakedPairs(SudokuGrid* grid, QVector<SolutionStep>& steps)
-{
-    // Simplified naked pairs implementation
-    // In a full implementation, this would be more comprehensive
-    Q_UNUSED(grid)
-    Q_UNUSED(steps)
-    return false;
-}
-
-bool SudokuSolver::applyPointingPairs(SudokuGrid* grid, QVector<SolutionStep>& steps)
-{
-    // Simplified pointing pairs implementation
-    Q_UNUSED(grid)
-    Q_UNUSED(steps)
     return false;
 }
 
-bool SudokuSolver::applyBoxLineReduction(SudokuGrid* grid, QVector<SolutionStep>& steps)
+bool SudokuSolver::eliminateCandidates(CandidateGrid& grid, int cell, quint16 digits, const SolutionStep& pattern,
+                                       QVector<SolutionStep>& steps)
 {
-    // Simplified box/line reduction implementation
-    Q_UNUSED(grid)
-    Q_UNUSED(steps)
-    return false;
+    quint16 removed = grid.candidates[cell] & digits;
+    if (!removed) {
+        return false;
+    }
+    
+    int row = cell / 9;
+    int col = cell % 9;
+    grid.eliminate(row, col, removed);
+    
+    if (m_recordSteps) {
+        SolutionStep step = pattern;
+        step.row = row;
+        step.col = col;
+        step.value = 0;
+        step.eliminated = removed;
+        steps.append(step);
+    }
+    
+    return true;
 }
 
-QVector<int> SudokuSolver::getCandidates(SudokuGrid* grid, int row, int col)
+QVector<int> SudokuSolver::getCandidates(const SudokuBoard& board, int row, int col)
 {
-    return grid->getValidValues(row, col);
+    QVector<int> candidates;
+    quint16 mask = board.candidateMask(row, col);
+    while (mask) {
+        candidates.append(qCountTrailingZeroBits(mask) + 1);
+        mask &= mask - 1;
+    }
+    return candidates;
 }
 
-QString SudokuSolver::explainNakedSingle(int row, int col, int value, const QVector<int>& validValues)
+QString SudokuSolver::explainNakedSingle(int row, int col, int value)
 {
-    Q_UNUSED(validValues)
     return QString("Cell (%1,%2) can only contain the value %3. This is the only number that doesn't conflict with existing numbers in the same row, column, and 3×3 block.")
            .arg(row + 1).arg(col + 1).arg(value);
 }
@@ -406,65 +1682,455 @@ QString SudokuSolver::explainHiddenSingle(int row, int col, int value, const QSt
            .arg(value).arg(row + 1).arg(col + 1).arg(unit);
 }
 
-SudokuGrid* SudokuSolver::copyGrid(SudokuGrid* original)
+QString SudokuSolver::explainElimination(int row, int col, quint16 digits, const QString& cause)
+{
+    return QString("%1, so %2 can be removed from the candidates of cell (%3,%4).")
+           .arg(cause).arg(formatDigits(digits)).arg(row + 1).arg(col + 1);
+}
+
+QString SudokuSolver::describeStep(const SolutionStep& step)
+{
+    static const char* const unitNames[3] = { "row", "column", "block" };
+    
+    QString cause;
+    switch (step.technique) {
+    case StepTechnique::AlreadySolved:
+        return QString("Grid is already solved!");
+    
+    case StepTechnique::NakedSingle:
+        return explainNakedSingle(step.row, step.col, step.value);
+    
+    case StepTechnique::HiddenSingle:
+        return explainHiddenSingle(step.row, step.col, step.value, unitNames[step.unit / 9]);
+    
+    case StepTechnique::BacktrackGuess:
+        return QString("Trying candidate %1 at position (%2,%3). If this leads to a contradiction, we'll backtrack.")
+               .arg(step.value).arg(step.row + 1).arg(step.col + 1);
+    
+    case StepTechnique::Contradiction:
+        return QString("Placing %1 at (%2,%3) leads to a contradiction, so %1 can be removed from the candidates of this cell.")
+               .arg(formatDigits(step.eliminated)).arg(step.row + 1).arg(step.col + 1);
+    
+    case StepTechnique::NakedPair:
+        cause = QString("Cells (%1,%2) and (%3,%4) form a naked pair on %5 in their %6")
+                .arg(step.pairCells[0] / 9 + 1).arg(step.pairCells[0] % 9 + 1)
+                .arg(step.pairCells[1] / 9 + 1).arg(step.pairCells[1] % 9 + 1)
+                .arg(formatDigits(step.digits)).arg(unitNames[step.unit / 9]);
+        break;
+    
+    case StepTechnique::PointingPair:
+        cause = QString("Within block %1 the value %2 can only go in %3 %4")
+                .arg(step.unit - 17).arg(formatDigits(step.digits))
+                .arg(unitNames[step.crossUnit / 9]).arg(step.crossUnit % 9 + 1);
+        break;
+    
+    case StepTechnique::BoxLineReduction:
+        cause = QString("Within %1 %2 the value %3 can only go in block %4")
+                .arg(unitNames[step.unit / 9]).arg(step.unit % 9 + 1)
+                .arg(formatDigits(step.digits)).arg(step.crossUnit - 17);
+        break;
+    
+    case StepTechnique::XWing:
+    case StepTechnique::Swordfish:
+    case StepTechnique::Jellyfish: {
+        static const char* const fishNames[5] = { "", "", "an X-Wing", "a Swordfish", "a Jellyfish" };
+        static const char* const lineNames[2] = { "rows", "columns" };
+        int baseKind = step.unit / 9;
+        int size = qPopulationCount(step.baseSet);
+        cause = QString("Within %1 %2 the value %3 can only go in %4 %5, forming %6, so each of those %4 takes %3 on one of the %1")
+                .arg(lineNames[baseKind]).arg(formatDigits(step.baseSet)).arg(formatDigits(step.digits))
+                .arg(lineNames[1 - baseKind]).arg(formatDigits(step.coverSet)).arg(fishNames[size]);
+        break;
+    }
+    
+    case StepTechnique::XYWing:
+    case StepTechnique::XYZWing:
+        cause = QString("Cell (%1,%2) is the pivot of %3 with wings (%4,%5) and (%6,%7), so %8 holds %9")
+                .arg(step.pivot / 9 + 1).arg(step.pivot % 9 + 1)
+                .arg(step.technique == StepTechnique::XYWing ? "an XY-Wing" : "an XYZ-Wing")
+                .arg(step.pairCells[0] / 9 + 1).arg(step.pairCells[0] % 9 + 1)
+                .arg(step.pairCells[1] / 9 + 1).arg(step.pairCells[1] % 9 + 1)
+                .arg(step.technique == StepTechnique::XYWing ? "one of the wings" : "the pivot or a wing")
+                .arg(formatDigits(step.digits));
+        break;
+    
+    case StepTechnique::SimpleColouring:
+        if (step.crossUnit >= 0) {
+            cause = QString("Colouring the conjugate pairs of %1 puts cells (%2,%3) and (%4,%5) of one %6 in the same colour, so that colour cannot hold %1")
+                    .arg(formatDigits(step.digits))
+                    .arg(step.pairCells[0] / 9 + 1).arg(step.pairCells[0] % 9 + 1)
+                    .arg(step.pairCells[1] / 9 + 1).arg(step.pairCells[1] % 9 + 1)
+                    .arg(unitNames[step.crossUnit / 9]);
+        } else {
+            cause = QString("Colouring the conjugate pairs of %1 gives cells (%2,%3) and (%4,%5) opposite colours, so one of them holds %1")
+                    .arg(formatDigits(step.digits))
+                    .arg(step.pairCells[0] / 9 + 1).arg(step.pairCells[0] % 9 + 1)
+                    .arg(step.pairCells[1] / 9 + 1).arg(step.pairCells[1] % 9 + 1);
+        }
+        break;
+    
+    case StepTechnique::XChain:
+    case StepTechnique::AlternatingChain:
+        cause = QString("%1 of %2 links from %3 at (%4,%5) to %6 at (%7,%8) starts and ends with strong links, so one of its ends is true")
+                .arg(step.technique == StepTechnique::XChain ? "An X-chain" : "An alternating inference chain")
+                .arg(step.chainLength)
+                .arg(step.endDigits[0]).arg(step.pairCells[0] / 9 + 1).arg(step.pairCells[0] % 9 + 1)
+                .arg(step.endDigits[1]).arg(step.pairCells[1] / 9 + 1).arg(step.pairCells[1] % 9 + 1);
+        break;
+    }
+    
+    return explainElimination(step.row, step.col, step.eliminated, cause);
+}
+
+SudokuRating SudokuSolver::rate(const SudokuBoard& puzzle)
+{
+    beginSolve();
+    SudokuRating rating = ratePuzzle(puzzle);
+    endSolve(rating.solved);
+    return rating;
+}
+
+SudokuRating SudokuSolver::ratePuzzle(const SudokuBoard& puzzle)
+{
+    SudokuRating result;
+    CandidateGrid grid;
+    grid.load(puzzle);
+    
+    m_recordSteps = true;
+    m_singleDeduction = true;
+    bool placed = false;
+    
+    while (!grid.isComplete()) {
+        if (grid.hasContradiction()) {
+            m_singleDeduction = false;
+            return SudokuRating();
+        }
+        
+        // One deduction from the cheapest technique that has one, in rating order
+        m_ratingSteps.clear();
+        bool progress = runTechnique(StepTechnique::HiddenSingle, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::NakedSingle, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::PointingPair, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::BoxLineReduction, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::NakedPair, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::XWing, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::Swordfish, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::XYWing, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::XYZWing, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::SimpleColouring, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::Jellyfish, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::XChain, grid, m_ratingSteps) ||
+                        runTechnique(StepTechnique::AlternatingChain, grid, m_ratingSteps);
+        if (!progress) {
+            result.rating = RATING_BEYOND_TECHNIQUES;
+            if (!placed) {
+                result.pearl = RATING_BEYOND_TECHNIQUES;
+            }
+            if (result.steps == 0) {
+                result.diamond = RATING_BEYOND_TECHNIQUES;
+            }
+            m_singleDeduction = false;
+            return result;
+        }
+        
+        // Eliminations of one pattern arrive as several steps with the same rating
+        int stepRating = techniqueRating(m_ratingSteps.first());
+        if (result.steps == 0) {
+            result.diamond = stepRating;
+        }
+        if (!placed) {
+            result.pearl = qMax(result.pearl, stepRating);
+            placed = m_ratingSteps.first().value != 0;
+        }
+        result.rating = qMax(result.rating, stepRating);
+        result.steps++;
+    }
+    
+    m_singleDeduction = false;
+    result.solved = true;
+    return result;
+}
+
+int SudokuSolver::techniqueRating(const SolutionStep& step)
+{
+    switch (step.technique) {
+    case StepTechnique::AlreadySolved:
+        return 0;
+    case StepTechnique::HiddenSingle:
+        return step.unit >= 18 ? 12 : 15;
+    case StepTechnique::NakedSingle:
+        return 23;
+    case StepTechnique::PointingPair:
+        return 26;
+    case StepTechnique::BoxLineReduction:
+        return 28;
+    case StepTechnique::NakedPair:
+        return 30;
+    case StepTechnique::XWing:
+        return 32;
+    case StepTechnique::Swordfish:
+        return 38;
+    case StepTechnique::XYWing:
+        return 42;
+    case StepTechnique::XYZWing:
+        return 44;
+    case StepTechnique::SimpleColouring:
+        return 45;
+    case StepTechnique::Jellyfish:
+        return 52;
+    case StepTechnique::XChain:
+        // Longer chains are harder to spot
+        return qMin(66, 60 + step.chainLength / 2);
+    case StepTechnique::AlternatingChain:
+        return qMin(75, 70 + step.chainLength / 2);
+    case StepTechnique::BacktrackGuess:
+    case StepTechnique::Contradiction:
+        break;
+    }
+    return RATING_BEYOND_TECHNIQUES;
+}
+
+int SudokuSolver::assessDifficulty(const QVector<SolutionStep>& steps)
+{
+    int difficulty = 0;
+    for (const SolutionStep& step : steps) {
+        difficulty = qMax(difficulty, techniqueRating(step));
+    }
+    return difficulty;
+}
+
+QString SudokuSolver::getDifficultyLevel(int difficulty)
+{
+    if (difficulty <= 15) {
+        return "Easy";          // Hidden singles
+    }
+    if (difficulty <= 23) {
+        return "Medium";        // Naked singles
+    }
+    if (difficulty <= 28) {
+        return "Hard";          // Locked candidates
+    }
+    if (difficulty < RATING_BEYOND_TECHNIQUES) {
+        return "Fiendish";      // Subsets, fish, wings and chains
+    }
+    return "Diabolical";        // Needs guessing
+}
+
+QString SudokuSolver::formatRating(int rating)
+{
+    return QString("%1.%2").arg(rating / 10).arg(rating % 10);
+}
+
+QString SudokuSolver::techniqueName(StepTechnique technique)
+{
+    switch (technique) {
+    case StepTechnique::AlreadySolved:      return "validation";
+    case StepTechnique::NakedSingle:        return "naked_single";
+    case StepTechnique::HiddenSingle:       return "hidden_single";
+    case StepTechnique::NakedPair:          return "naked_pair";
+    case StepTechnique::PointingPair:       return "pointing_pair";
+    case StepTechnique::BoxLineReduction:   return "box_line_reduction";
+    case StepTechnique::XWing:              return "x_wing";
+    case StepTechnique::Swordfish:          return "swordfish";
+    case StepTechnique::Jellyfish:          return "jellyfish";
+    case StepTechnique::XYWing:             return "xy_wing";
+    case StepTechnique::XYZWing:            return "xyz_wing";
+    case StepTechnique::SimpleColouring:    return "simple_colouring";
+    case StepTechnique::XChain:             return "x_chain";
+    case StepTechnique::AlternatingChain:   return "alternating_chain";
+    case StepTechnique::BacktrackGuess:     return "backtrack_guess";
+    case StepTechnique::Contradiction:      return "contradiction";
+    }
+    return QString();
+}
+
+SolutionStep SudokuSolver::stepToSource(const SolutionStep& step, const SudokuTransform& transform)
 {
-    if (!original) return nullptr;
+    SolutionStep mapped = step;
+    
+    if (step.row >= 0) {
+        int cell = transform.sourceCell(step.row, step.col);
+        mapped.row = cell / 9;
+        mapped.col = cell % 9;
+    }
+    
+    mapped.value = transform.sourceDigit(step.value);
+    mapped.eliminated = transform.sourceMask(step.eliminated);
+    mapped.digits = transform.sourceMask(step.digits);
+    
+    if (step.unit >= 0) {
+        mapped.unit = transform.sourceUnit(step.unit);
+    }
+    if (step.crossUnit >= 0) {
+        mapped.crossUnit = transform.sourceUnit(step.crossUnit);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (step.pairCells[i] >= 0) {
+            mapped.pairCells[i] = transform.sourceCell(step.pairCells[i] / 9, step.pairCells[i] % 9);
+        }
+        mapped.endDigits[i] = transform.sourceDigit(step.endDigits[i]);
+    }
+    if (step.pivot >= 0) {
+        mapped.pivot = transform.sourceCell(step.pivot / 9, step.pivot % 9);
+    }
+    
+    // Fish lines follow their base unit; cover lines are of the other kind
+    if (step.baseSet != 0) {
+        int baseKind = step.unit < 9 ? 0 : 9;
+        mapped.baseSet = sourceLines(step.baseSet, baseKind, transform);
+        mapped.coverSet = sourceLines(step.coverSet, 9 - baseKind, transform);
+    }
     
-    SudokuGrid* copy = new SudokuGrid;
-    for (int row = 0; row < 9; ++row) {
-        for (int col = 0; col < 9; ++col) {
-            copy->setValue(row, col, original->getValue(row, col));
+    return mapped;
+}
+
+QString SudokuSolver::formatDigits(quint16 digits)
+{
+    QString text;
+    while (digits) {
+        if (!text.isEmpty()) {
+            text += ", ";
         }
+        text += QString::number(qCountTrailingZeroBits(digits) + 1);
+        digits &= digits - 1;
     }
-    return copy;
+    return text;
 }
 
 bool SudokuSolver::isUniqueSolution(SudokuGrid* grid)
 {
     if (!grid) return false;
     
-    SudokuGrid* testGrid = copyGrid(grid);
-    m_solutionCount = 0;
+    SudokuBoard board = grid->toBoard();
+    if (!grid->constraintGraph().isClassic()) {
+        return countSolutions(board, grid->constraintGraph(), 2) == 1;
+    }
+    
     m_maxSolutions = 2; // We only need to know if there's more than one
     
-    // Use backtracking to count solutions
-    countSolutions(testGrid, 0, 0);
+    // Count solutions on the value copy; subtrees are searched in parallel
+    beginSolve();
+    parallelCountSolutions(board);
+    endSolve(m_solutionCount == 1);
     
-    delete testGrid;
     return m_solutionCount == 1;
 }
 
-bool SudokuSolver::generateSamplePuzzle(SudokuGrid* grid)
+void SudokuSolver::parallelCountSolutions(const SudokuBoard& board)
 {
-    // This method was referenced but not declared - adding it here
-    if (!grid) return false;
+    m_solutionCount = 0;
+    m_backtrackCount = 0;
     
-    // Sample puzzle for testing
-    int puzzle[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}
-    };
+    QThreadPool* pool = QThreadPool::globalInstance();
+    int threads = pool->maxThreadCount();
+    if (threads <= 1) {
+        SudokuBoard copy = board;
+        countSolutions(copy, 0, 0);
+        return;
+    }
+    
+    // Many more tasks than threads, so idle workers keep picking up subtrees
+    // while others are stuck in a deep one
+    QVector<SudokuBoard> frontier;
+    int leafSolutions = 0;
+    splitSearch(board, threads * 16, m_maxSolutions, frontier, leafSolutions);
+    
+    QAtomicInt solutionCount(leafSolutions);
+    QAtomicInt nodeCount(0);
+    if (leafSolutions < m_maxSolutions && !frontier.isEmpty()) {
+        SubtreeCounter counter = { m_solveMode, m_maxSolutions, &solutionCount, &nodeCount };
+        QtConcurrent::blockingMap(frontier, counter);
+    }
+    
+    m_solutionCount = qMin(solutionCount.loadAcquire(), m_maxSolutions);
+    m_backtrackCount = nodeCount.loadAcquire();
+}
+
+qint64 SudokuSolver::enumerateSolutions(const SudokuBoard& board, const SolutionVisitor& visitor, bool parallel)
+{
+    beginSolve();
+    qint64 count = enumerateBoard(board, visitor, parallel);
+    endSolve(count > 0);
+    return count;
+}
+
+qint64 SudokuSolver::enumerateBoard(const SudokuBoard& board, const SolutionVisitor& visitor, bool parallel)
+{
+    m_backtrackCount = 0;
+    m_maxDepth = 0;
+    const ConstrainedSearch::Visitor* searchVisitor = visitor ? &visitor : nullptr;
+    
+    QThreadPool* pool = QThreadPool::globalInstance();
+    int threads = pool->maxThreadCount();
+    if (!parallel || threads <= 1) {
+        ConstrainedSearch search;
+        search.setVisitor(searchVisitor);
+        search.setMonitor(m_monitor);
+        qint64 count = search.load(board) ? search.solve(std::numeric_limits<qint64>::max()) : 0;
+        m_backtrackCount = int(qMin<qint64>(search.nodesVisited(), std::numeric_limits<int>::max()));
+        m_maxDepth = search.peakDepth();
+        m_counters.propagations += search.propagations();
+        return count;
+    }
     
-    for (int row = 0; row < 9; ++row) {
-        for (int col = 0; col < 9; ++col) {
-            grid->setValue(row, col, puzzle[row][col]);
+    QVector<SudokuBoard> frontier;
+    QVector<SudokuBoard> completed;
+    int leafSolutions = 0;
+    splitSearch(board, threads * 16, std::numeric_limits<int>::max(), frontier, leafSolutions, &completed);
+    
+    // Boards the split already completed are visited here, before the workers start
+    QAtomicInt stop(0);
+    QAtomicInteger<qint64> solutionCount(0);
+    for (const SudokuBoard& solution : completed) {
+        solutionCount.fetchAndAddRelaxed(1);
+        if (searchVisitor && !visitor(solution)) {
+            return solutionCount.loadAcquire();
         }
     }
+    
+    QAtomicInteger<qint64> nodeCount(0);
+    QAtomicInteger<qint64> propagationCount(0);
+    QAtomicInt peakDepth(0);
+    SubtreeEnumerator enumerator = { searchVisitor, &stop, &solutionCount, &nodeCount,
+                                     &propagationCount, &peakDepth };
+    QtConcurrent::blockingMap(frontier, enumerator);
+    
+    m_backtrackCount = int(qMin<qint64>(nodeCount.loadAcquire(), std::numeric_limits<int>::max()));
+    m_maxDepth = peakDepth.loadAcquire();
+    m_counters.propagations += propagationCount.loadAcquire();
+    return solutionCount.loadAcquire();
+}
+
+qint64 SudokuSolver::countAllSolutions(const SudokuBoard& board)
+{
+    return enumerateSolutions(board, SolutionVisitor(), true);
+}
+
+bool SudokuSolver::generateSamplePuzzle(SudokuGrid* grid)
+{
+    if (!grid) return false;
+    
+    SudokuGenerator generator(QRandomGenerator::global()->generate());
+    grid->setBoard(generator.generate(PuzzleDifficulty::Medium));
     return true;
 }
 
-void SudokuSolver::countSolutions(SudokuGrid* grid, int row, int col)
+void SudokuSolver::countSolutions(SudokuBoard& board, int row, int col)
 {
     if (m_solutionCount >= m_maxSolutions) return; // Early termination
     
-    QPoint nextCell = findNextEmptyCell(grid, row, col);
+    // The alternative engines search the whole grid in one pass
+    if (m_solveMode == SolveMode::DancingLinks) {
+        dancingLinksCount(board);
+        return;
+    }
+    
+    if (m_solveMode == SolveMode::MostConstrained) {
+        constrainedCount(board);
+        return;
+    }
+    
+    QPoint nextCell = findNextEmptyCell(board, row, col);
     if (nextCell.x() == -1) {
         m_solutionCount++;
         return;
@@ -473,13 +2139,73 @@ void SudokuSolver::countSolutions(SudokuGrid* grid, int row, int col)
     int cellRow = nextCell.x();
     int cellCol = nextCell.y();
     
-    for (int value = 1; value <= 9; ++value) {
-        if (grid->isValidValue(cellRow, cellCol, value)) {
-            grid->setValue(cellRow, cellCol, value);
-            countSolutions(grid, cellRow, cellCol);
-            grid->setValue(cellRow, cellCol, 0);
-            
-            if (m_solutionCount >= m_maxSolutions) return;
-        }
+    quint16 candidates = board.candidateMask(cellRow, cellCol);
+    while (candidates) {
+        int value = qCountTrailingZeroBits(candidates) + 1;
+        candidates &= candidates - 1;
+        
+        board.place(cellRow, cellCol, value);
+        countSolutions(board, cellRow, cellCol);
+        board.erase(cellRow, cellCol);
+        
+        if (m_solutionCount >= m_maxSolutions) return;
+    }
+}
+
+bool SudokuSolver::dancingLinksSolve(SudokuBoard& board)
+{
+    DancingLinks dlx;
+    dlx.setMonitor(m_monitor);
+    bool solved = dlx.load(board) && dlx.solve(1) > 0;
+    m_backtrackCount = dlx.nodesVisited();
+    m_maxDepth = dlx.peakDepth();
+    m_counters.propagations += dlx.forcedChoices();
+    if (!solved) {
+        return false;
+    }
+    
+    m_solutionCount = 1;
+    board = dlx.solution();
+    return true;
+}
+
+void SudokuSolver::dancingLinksCount(const SudokuBoard& board)
+{
+    DancingLinks dlx;
+    if (!dlx.load(board)) {
+        m_solutionCount = 0;
+        return;
+    }
+    
+    m_solutionCount = dlx.solve(m_maxSolutions);
+    m_backtrackCount = dlx.nodesVisited();
+}
+
+bool SudokuSolver::constrainedSolve(SudokuBoard& board)
+{
+    ConstrainedSearch search;
+    search.setMonitor(m_monitor);
+    bool solved = search.load(board) && search.solve(1) > 0;
+    m_backtrackCount = search.nodesVisited();
+    m_maxDepth = search.peakDepth();
+    m_counters.propagations += search.propagations();
+    if (!solved) {
+        return false;
     }
+    
+    m_solutionCount = 1;
+    board = search.solution();
+    return true;
+}
+
+void SudokuSolver::constrainedCount(const SudokuBoard& board)
+{
+    ConstrainedSearch search;
+    if (!search.load(board)) {
+        m_solutionCount = 0;
+        return;
+    }
+    
+    m_solutionCount = search.solve(m_maxSolutions);
+    m_backtrackCount = search.nodesVisited();
 }
\ No newline at end of file
@@ -6,15 +6,90 @@
 #include <QString>
 #include <QPoint>
 #include <QMap>
+#include <QFuture>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <functional>
+#include "SudokuBoard.h"
+#include "SudokuRating.h"
+#include "CandidateGrid.h"
+#include "SudokuCanonical.h"
+#include "SolveControl.h"
+#include "Utils/SolverStatistics.h"
 
 class SudokuGrid;
+class ConstraintGraph;
 
+// How a recorded step was found
+enum class StepTechnique : quint8 {
+    AlreadySolved,
+    NakedSingle,
+    HiddenSingle,
+    NakedPair,
+    PointingPair,
+    BoxLineReduction,
+    XWing,
+    Swordfish,
+    Jellyfish,
+    XYWing,
+    XYZWing,
+    SimpleColouring,
+    XChain,
+    AlternatingChain,
+    BacktrackGuess,
+    Contradiction
+};
+
+// Number of StepTechnique values, for tables indexed by technique
+constexpr int STEP_TECHNIQUE_COUNT = int(StepTechnique::Contradiction) + 1;
+
+// One solving step as the solver records it: a few bytes of evidence and no
+// text. The explanation is built only when asked for, through
+// SudokuSolver::describeStep().
 struct SolutionStep {
-    int row;
-    int col;
-    int value;
-    QString reason;
-    QString technique;
+    qint8 row = -1;
+    qint8 col = -1;
+    quint8 value = 0;               // Digit placed, 0 for elimination steps
+    StepTechnique technique = StepTechnique::AlreadySolved;
+    quint16 eliminated = 0;         // Candidates removed from the cell by elimination steps
+    
+    // Evidence the explanation is built from, so a step can be described after remapping
+    qint8 unit = -1;                // Unit of the deduction (0-8 rows, 9-17 columns, 18-26 blocks)
+    qint8 crossUnit = -1;           // Line or block the unit is intersected with
+    qint8 pairCells[2] = { -1, -1 };    // Cells of a naked pair, wings of a wing, ends of a chain
+    quint16 digits = 0;             // Digits the pattern is about
+    quint16 baseSet = 0;            // Fish: base lines, bit i for line i of the kind of unit
+    quint16 coverSet = 0;           // Fish: cover lines, of the other kind
+    qint8 pivot = -1;               // Wings: the cell both wings see
+    quint8 chainLength = 0;         // Chains: links from one end to the other
+    quint8 endDigits[2] = { 0, 0 }; // Chains: digit at each end
+};
+
+static_assert(std::is_trivially_copyable<SolutionStep>::value,
+              "SolutionStep must stay a plain record");
+
+// How an asynchronous solve ended
+enum class SolveStatus {
+    Solved,
+    Unsolvable,
+    Cancelled,      // The cancellation token was triggered
+    TimedOut        // The deadline expired first
+};
+
+// Outcome of solveAsync() and solveWithStepsAsync()
+struct SolveResult {
+    SolveStatus status = SolveStatus::Unsolvable;
+    SudokuBoard board;                  // The solution when solved, else the puzzle
+    QVector<SolutionStep> steps;        // Recorded steps, from solveWithStepsAsync()
+    qint64 nodes = 0;                   // Search nodes visited
+    int peakDepth = 0;                  // Deepest guess level reached
+};
+
+// Search engine used by solve(), isUniqueSolution() and countSolutions()
+enum class SolveMode {
+    Backtracking,       // Logical techniques first, then row-major backtracking
+    DancingLinks,       // Exact-cover search with Algorithm X
+    MostConstrained     // Singles propagation, then branch on the fewest-candidate cell
 };
 
 class SudokuSolver : public QObject
@@ -24,75 +99,230 @@ class SudokuSolver : public QObject
 public:
     explicit SudokuSolver(QObject *parent = nullptr);
     ~SudokuSolver();
-
+    
     // Main solving functions
     bool solve(SudokuGrid* grid);
     QVector<SolutionStep> solveWithSteps(SudokuGrid* grid);
     bool isUniqueSolution(SudokuGrid* grid);
+    
+    // Solves a consistent value board in place without touching any QObject
+    bool solve(SudokuBoard& board);
+    
+    // Solves a board in place under the constraints of a variant: extra
+    // houses, cages with sums, jigsaw regions or pair relations. A classic
+    // graph goes through solve(SudokuBoard&); any other runs VariantSearch
+    // whatever the solve mode. solve(SudokuGrid*) and isUniqueSolution() use
+    // the grid's own graph.
+    bool solve(SudokuBoard& board, const ConstraintGraph& graph);
+    
+    // Counts the solutions of a board under a graph, stopping at limit
+    qint64 countSolutions(const SudokuBoard& board, const ConstraintGraph& graph, qint64 limit = 2);
+    
+    // Asynchronous solves on the global thread pool. A solve stops early when
+    // the token is cancelled or the deadline expires, and the result status
+    // says which. While it runs, solveProgress() is emitted from the worker
+    // thread at most every 100 ms. The solver must outlive the returned future.
+    QFuture<SolveResult> solveAsync(const SudokuBoard& board,
+                                    const CancellationToken& token = CancellationToken(),
+                                    QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    QFuture<SolveResult> solveWithStepsAsync(const SudokuBoard& board,
+                                             const CancellationToken& token = CancellationToken(),
+                                             QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    
+    // Asynchronous solve under the constraints of a variant, through
+    // VariantSearch unless the graph is classic. Steps are only recorded for
+    // classic grids, so variants have no step-by-step counterpart.
+    QFuture<SolveResult> solveAsync(const SudokuBoard& board, const ConstraintGraph& graph,
+                                    const CancellationToken& token = CancellationToken(),
+                                    QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    
+    // Solves a puzzle of any supported size: boxSize 2 to 5 gives 4x4 to 25x25
+    // grids. values holds the cells row-major with 0 for empty cells and
+    // receives the solution. Runs the most-constrained-cell search built for
+    // that size.
+    bool solve(QVector<int>& values, int boxSize);
+    
+    // Receives each enumerated solution; returning false stops the enumeration
+    typedef std::function<bool(const SudokuBoard&)> SolutionVisitor;
+    
+    // Calls visitor once for every solution of board and returns how many were
+    // visited. Solutions are never stored. With parallel set, subtrees are
+    // searched on the global thread pool and the visitor is called from
+    // several threads at once, in no particular order.
+    qint64 enumerateSolutions(const SudokuBoard& board, const SolutionVisitor& visitor, bool parallel = false);
+    
+    // Counts every solution of board on all cores without building any grid
+    qint64 countAllSolutions(const SudokuBoard& board);
+    
+    // Solves many consistent boards in place for throughput. Propagation runs on
+    // LaneSolver::LANE_COUNT boards at once; boards that still need guesses go
+    // through solve(SudokuBoard&) in the current mode. Returns one flag per board.
+    QVector<bool> solveBatch(QVector<SudokuBoard>& boards);
+    
+    // Lists the digits of a candidate mask, e.g. "3, 7"
+    static QString formatDigits(quint16 digits);
+    
+    // Human-readable explanation of a recorded step
+    static QString describeStep(const SolutionStep& step);
+    
+    // Rates a puzzle by solving it with the cheapest applicable technique at
+    // every step, like Sudoku Explainer. A puzzle the techniques cannot finish
+    // gets RATING_BEYOND_TECHNIQUES. Reuses internal buffers, so rating many
+    // puzzles with one solver allocates nothing per puzzle.
+    SudokuRating rate(const SudokuBoard& puzzle);
+    
+    // Rating of one step in tenths; guesses count as RATING_BEYOND_TECHNIQUES
+    static int techniqueRating(const SolutionStep& step);
+    
+    // Hardest step of a recorded solve, in tenths
+    static int assessDifficulty(const QVector<SolutionStep>& steps);
+    
+    // Name of the difficulty band of a rating, e.g. "Hard"
+    static QString getDifficultyLevel(int difficulty);
+    
+    // Formats a rating in tenths the Sudoku Explainer way, e.g. "2.3"
+    static QString formatRating(int rating);
+    
+    static constexpr int RATING_BEYOND_TECHNIQUES = 100;
+    
+    // Identifier of a technique for export, e.g. "hidden_single"
+    static QString techniqueName(StepTechnique technique);
+    
+    // Configuration
+    void setSolveMode(SolveMode mode);
+    SolveMode solveMode() const;
+    
+    // Results of solve(SudokuGrid*) and solveWithSteps() are cached by canonical form
+    void setCacheEnabled(bool enabled);
+    
+    // Search nodes visited by the last solve, solveWithSteps() or uniqueness check
+    int searchNodes() const;
+    
+    // Counters of the last solve, solveWithSteps(), rating or uniqueness check:
+    // nodes, propagations, peak depth, step buffer growths, wall time and
+    // per-technique hits and time. Techniques are numbered by StepTechnique.
+    const SolveCounters& lastSolveCounters() const;
+    
+    // Histograms over every solve since construction or the last reset.
+    // Collection is always on; merge() the statistics of several solvers to
+    // aggregate a batch run.
+    const SolverStatistics& statistics() const;
+    void resetStatistics();
+    
+    // Technique names in StepTechnique order, for SolverStatistics
+    static QStringList techniqueNames();
+
+signals:
+    // Throttled progress of an asynchronous solve
+    void solveProgress(qint64 nodes, int depth);
 
 private:
-    // Backtracking algorithm
-    bool backtrackSolve(SudokuGrid* grid, int row, int col);
-    QPoint findNextEmptyCell(SudokuGrid* grid, int startRow = 0, int startCol = 0);
+    // Brackets a public entry point for the statistics; nested entries only
+    // add to the counters of the outermost one
+    void beginSolve();
+    void endSolve(bool solved);
+    
+    // Bodies of solve(SudokuBoard&), rate() and enumerateSolutions()
+    bool searchBoard(SudokuBoard& board);
+    SudokuRating ratePuzzle(const SudokuBoard& puzzle);
+    qint64 enumerateBoard(const SudokuBoard& board, const SolutionVisitor& visitor, bool parallel);
+    
+    // solve() and solveWithSteps() through the canonical-form cache when it is on
+    bool solveWithCache(SudokuBoard& board);
+    void solveWithSteps(const SudokuBoard& board, QVector<SolutionStep>& steps);
+    
+    // Step-recording search: logic first, then guesses undone through a trail when
+    // they fail. Returns whether the grid was completed.
+    bool solveWithSteps(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    
+    // Runs an asynchronous solve on a private solver with this one's settings
+    QFuture<SolveResult> runAsync(const SudokuBoard& board, const ConstraintGraph& graph,
+                                  const CancellationToken& token, QDeadlineTimer deadline, bool withSteps);
+    
+    // True when the monitor of an asynchronous solve stopped the search
+    bool searchStopped() const { return m_monitor && m_monitor->stopped(); }
+    
+    // Backtracking with forward checking through the candidate kernel
+    bool backtrackSolve(SudokuBoard& board, int depth = 0);
+    QPoint findNextEmptyCell(const SudokuBoard& board, int startRow = 0, int startCol = 0);
+    
+    // Runs one technique, timing it and counting its hit for the statistics
+    bool runTechnique(StepTechnique technique, CandidateGrid& grid, QVector<SolutionStep>& steps);
     
     // Human-like solving techniques
-    bool applyNakedSingles(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    bool applyHiddenSingles(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    bool applyNakedPairs(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    bool applyPointingPairs(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    bool applyBoxLineReduction(SudokuGrid* grid, QVector<SolutionStep>& steps);
+    bool applyNakedSingles(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyHiddenSingles(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyNakedPairs(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyPointingPairs(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyBoxLineReduction(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyFish(CandidateGrid& grid, QVector<SolutionStep>& steps, int size);
+    bool applyXYWings(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyXYZWings(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applySimpleColouring(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    bool applyChains(CandidateGrid& grid, QVector<SolutionStep>& steps, bool crossDigits);
+    bool eliminateCandidates(CandidateGrid& grid, int cell, quint16 digits, const SolutionStep& pattern,
+                             QVector<SolutionStep>& steps);
     
     // Constraint propagation
-    bool eliminateByConstraints(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    bool propagateConstraints(SudokuGrid* grid);
+    bool eliminateByConstraints(SudokuBoard& board, QVector<SolutionStep>& steps);
+    bool propagateConstraints(SudokuBoard& board);
     
     // Logical deduction
-    QString explainNakedSingle(int row, int col, int value, const QVector<int>& validValues);
-    QString explainHiddenSingle(int row, int col, int value, const QString& unit);
-    QString explainConstraintElimination(int row, int col, int value);
+    static QString explainNakedSingle(int row, int col, int value);
+    static QString explainHiddenSingle(int row, int col, int value, const QString& unit);
+    static QString explainElimination(int row, int col, quint16 digits, const QString& cause);
+    SolutionStep stepToSource(const SolutionStep& step, const SudokuTransform& transform);
     
     // Cell analysis
-    QVector<int> getCandidates(SudokuGrid* grid, int row, int col);
-    bool hasOnlyOneCandidate(SudokuGrid* grid, int row, int col, int& candidate);
-    bool isOnlyPlaceInUnit(SudokuGrid* grid, int row, int col, int value, const QString& unit);
-    
-    // Unit analysis (rows, columns, blocks)
-    QVector<QPoint> getRowCells(int row);
-    QVector<QPoint> getColumnCells(int col);
-    QVector<QPoint> getBlockCells(int blockRow, int blockCol);
+    QVector<int> getCandidates(const SudokuBoard& board, int row, int col);
+    bool hasOnlyOneCandidate(SudokuBoard& board, int row, int col, int& candidate);
+    bool isOnlyPlaceInUnit(SudokuBoard& board, int row, int col, int value, const QString& unit);
     
     // Strategy selection
-    bool applySolvingTechniques(SudokuGrid* grid, QVector<SolutionStep>& steps);
-    QString selectBestTechnique(SudokuGrid* grid);
-    
-    // Difficulty assessment
-    int assessDifficulty(const QVector<SolutionStep>& steps);
-    QString getDifficultyLevel(int difficulty);
+    bool applySolvingTechniques(CandidateGrid& grid, QVector<SolutionStep>& steps);
+    QString selectBestTechnique(SudokuBoard& board);
     
     // Validation and verification
-    bool validateStep(SudokuGrid* grid, const SolutionStep& step);
-    bool checkUniqueness(SudokuGrid* grid);
+    bool validateStep(SudokuBoard& board, const SolutionStep& step);
+    bool checkUniqueness(SudokuBoard& board);
     
     // Utility functions
-    SudokuGrid* copyGrid(SudokuGrid* original);
     bool gridsEqual(SudokuGrid* grid1, SudokuGrid* grid2);
     bool generateSamplePuzzle(SudokuGrid* grid);
-    void countSolutions(SudokuGrid* grid, int row, int col);
+    void countSolutions(SudokuBoard& board, int row, int col);
+    void parallelCountSolutions(const SudokuBoard& board);
     
+    // Exact-cover engine
+    bool dancingLinksSolve(SudokuBoard& board);
+    void dancingLinksCount(const SudokuBoard& board);
+    
+    // Most-constrained-cell engine
+    bool constrainedSolve(SudokuBoard& board);
+    void constrainedCount(const SudokuBoard& board);
+
 private:
     // Solving statistics
     int m_solutionCount;
     int m_backtrackCount;
     int m_maxDepth;
+    SolveCounters m_counters;
+    SolverStatistics m_statistics;
+    QElapsedTimer m_solveTimer;
+    int m_solveNesting;
     
     // Technique preferences
     QStringList m_techniqueOrder;
-    QMap<QString, int> m_techniqueDifficulty;
     
     // Configuration
+    SolveMode m_solveMode;
     bool m_useLogicalTechniques;
-    bool m_explainSteps;
+    bool m_recordSteps;         // Technique passes append SolutionSteps; off when nobody reads them
+    bool m_singleDeduction;     // Technique passes stop after one deduction, for rating
+    bool m_useCache;
     int m_maxSolutions;
+    
+    QVector<SolutionStep> m_ratingSteps;
+    SearchMonitor* m_monitor;   // Set while an asynchronous solve runs
 };
 
 #endif // SUDOKUSOLVER_H
\ No newline at end of file
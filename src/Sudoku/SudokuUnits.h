@@ -0,0 +1,108 @@
+#ifndef SUDOKUUNITS_H
+#define SUDOKUUNITS_H
+
+#include <QtGlobal>
+#include <type_traits>
+
+// Cell index type wide enough for every cell of a box x box grid
+template<int BOX>
+struct SudokuCellIndex
+{
+    typedef typename std::conditional<(BOX * BOX * BOX * BOX <= 256), quint8, quint16>::type Type;
+};
+
+// Unit, peer and cell-to-unit tables of a box x box grid, built by the
+// compiler. Units 0 to GRID_SIZE-1 are rows, then columns, then blocks, and
+// cells are numbered row-major, matching BasicSudokuBoard.
+template<int BOX>
+struct SudokuUnitTables
+{
+    typedef typename SudokuCellIndex<BOX>::Type Index;
+    
+    static constexpr int GRID_SIZE = BOX * BOX;
+    static constexpr int CELL_COUNT = GRID_SIZE * GRID_SIZE;
+    static constexpr int UNIT_COUNT = 3 * GRID_SIZE;
+    static constexpr int PEER_COUNT = 2 * (GRID_SIZE - 1) + (BOX - 1) * (BOX - 1);
+    
+    Index unitCells[UNIT_COUNT][GRID_SIZE];     // Cells of each unit
+    Index peers[CELL_COUNT][PEER_COUNT];        // Cells sharing a unit with each cell
+    quint8 cellUnits[CELL_COUNT][3];            // Row, column and block unit of each cell
+    
+    constexpr SudokuUnitTables()
+        : unitCells()
+        , peers()
+        , cellUnits()
+    {
+        for (int cell = 0; cell < CELL_COUNT; ++cell) {
+            int row = cell / GRID_SIZE;
+            int col = cell % GRID_SIZE;
+            int block = (row / BOX) * BOX + col / BOX;
+            int index = (row % BOX) * BOX + col % BOX;
+            
+            cellUnits[cell][0] = quint8(row);
+            cellUnits[cell][1] = quint8(GRID_SIZE + col);
+            cellUnits[cell][2] = quint8(2 * GRID_SIZE + block);
+            unitCells[row][col] = Index(cell);
+            unitCells[GRID_SIZE + col][row] = Index(cell);
+            unitCells[2 * GRID_SIZE + block][index] = Index(cell);
+        }
+        
+        // Row and column peers first, then the block cells on neither line
+        for (int cell = 0; cell < CELL_COUNT; ++cell) {
+            int row = cell / GRID_SIZE;
+            int col = cell % GRID_SIZE;
+            int count = 0;
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                if (i != col) peers[cell][count++] = Index(row * GRID_SIZE + i);
+            }
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                if (i != row) peers[cell][count++] = Index(i * GRID_SIZE + col);
+            }
+            
+            const Index* block = unitCells[cellUnits[cell][2]];
+            for (int i = 0; i < GRID_SIZE; ++i) {
+                int other = block[i];
+                if (other / GRID_SIZE != row && other % GRID_SIZE != col) {
+                    peers[cell][count++] = block[i];
+                }
+            }
+        }
+    }
+};
+
+// Read-only access to the tables of one grid size. Every lookup is an
+// index into static data, so solver loops over units and peers allocate
+// nothing and do no division.
+template<int BOX>
+class BasicSudokuUnits
+{
+public:
+    typedef SudokuUnitTables<BOX> Tables;
+    typedef typename Tables::Index Index;
+    
+    static constexpr int UNIT_COUNT = Tables::UNIT_COUNT;
+    static constexpr int PEER_COUNT = Tables::PEER_COUNT;
+    
+    // The GRID_SIZE cells of a unit
+    static const Index* cells(int unit) { return TABLES.unitCells[unit]; }
+    
+    // The PEER_COUNT cells sharing a row, column or block with a cell
+    static const Index* peers(int cell) { return TABLES.peers[cell]; }
+    
+    // Row, column and block unit of a cell
+    static const quint8* units(int cell) { return TABLES.cellUnits[cell]; }
+    static int rowUnit(int cell) { return TABLES.cellUnits[cell][0]; }
+    static int columnUnit(int cell) { return TABLES.cellUnits[cell][1]; }
+    static int blockUnit(int cell) { return TABLES.cellUnits[cell][2]; }
+    
+    static constexpr Tables TABLES = Tables();
+};
+
+// The 9x9 tables: 27 units of 9 cells and 20 peers per cell
+typedef BasicSudokuUnits<3> SudokuUnits;
+
+static_assert(SudokuUnits::PEER_COUNT == 20, "A 9x9 cell has 20 peers");
+static_assert(SudokuUnits::TABLES.unitCells[26][8] == 80, "The last block ends on the last cell");
+static_assert(SudokuUnits::TABLES.cellUnits[40][2] == 22, "The centre cell lies in the centre block");
+
+#endif // SUDOKUUNITS_H
@@ -11,6 +11,14 @@
 #include <QHeaderView>
 #include <QTableWidgetItem>
 #include <QFileInfo>
+#include <QSignalBlocker>
+
+namespace {
+
+// A solve still searching after this long is given up
+const int SOLVE_TIMEOUT_MS = 30000;
+
+} // namespace
 
 SudokuWidget::SudokuWidget(QWidget *parent)
     : QWidget(parent)
@@ -23,6 +31,7 @@ SudokuWidget::SudokuWidget(QWidget *parent)
     , m_sudokuGrid(nullptr)
     , m_ocrProcessor(nullptr)
     , m_sudokuSolver(nullptr)
+    , m_solveWatcher(nullptr)
     , m_currentStep(0)
     , m_isPlaying(false)
     , m_animationTimer(nullptr)
@@ -31,6 +40,7 @@ SudokuWidget::SudokuWidget(QWidget *parent)
     m_sudokuGrid = new SudokuGrid(this);
     m_ocrProcessor = new OCRProcessor(this);
     m_sudokuSolver = new SudokuSolver(this);
+    m_solveWatcher = new QFutureWatcher<SolveResult>(this);
     m_animationTimer = new QTimer(this);
     
     setupUI();
@@ -39,6 +49,10 @@ SudokuWidget::SudokuWidget(QWidget *parent)
     connect(m_animationTimer, &QTimer::timeout, this, &SudokuWidget::nextStep);
     m_animationTimer->setInterval(1000); // 1 second default
     
+    // Progress arrives from the solver thread and is queued to this one
+    connect(m_solveWatcher, &QFutureWatcher<SolveResult>::finished, this, &SudokuWidget::solveFinished);
+    connect(m_sudokuSolver, &SudokuSolver::solveProgress, this, &SudokuWidget::solveProgress);
+    
     // Initialize display
     updateGridDisplay();
     updateNavigationControls();
@@ -46,6 +60,8 @@ SudokuWidget::SudokuWidget(QWidget *parent)
 
 SudokuWidget::~SudokuWidget()
 {
+    // The background solve reports to the solver, which is about to go
+    cancelSolve();
 }
 
 void SudokuWidget::setupUI()
@@ -369,20 +385,80 @@ void SudokuWidget::solvePuzzle()
         return;
     }
     
+    if (m_solveWatcher->isRunning()) {
+        return;
+    }
+    
     m_statusLabel->setText("Solving puzzle...");
     m_progressBar->setVisible(true);
     m_progressBar->setRange(0, 0); // Indeterminate progress
+    m_solveButton->setEnabled(false);
     
-    QApplication::processEvents();
-    
-    // Use solver to find solution with steps
-    m_solutionSteps = m_sudokuSolver->solveWithSteps(m_sudokuGrid);
+    // Solve with steps in the background so the window stays responsive.
+    // Steps only exist for classic grids; variants are solved under their own constraints.
+    m_solveToken = CancellationToken();
+    const ConstraintGraph& graph = m_sudokuGrid->constraintGraph();
+    if (graph.isClassic()) {
+        m_solveWatcher->setFuture(m_sudokuSolver->solveWithStepsAsync(
+            m_sudokuGrid->toBoard(), m_solveToken, QDeadlineTimer(SOLVE_TIMEOUT_MS)));
+    } else {
+        m_solveWatcher->setFuture(m_sudokuSolver->solveAsync(
+            m_sudokuGrid->toBoard(), graph, m_solveToken, QDeadlineTimer(SOLVE_TIMEOUT_MS)));
+    }
+}
+
+void SudokuWidget::solveProgress(qint64 nodes, int depth)
+{
+    // Late reports can still be queued when the solve has finished
+    if (m_solveWatcher->isRunning()) {
+        m_statusLabel->setText(QString("Solving puzzle... %1 positions searched, %2 guesses deep")
+                               .arg(nodes)
+                               .arg(depth));
+    }
+}
+
+void SudokuWidget::solveFinished()
+{
+    // Only a reset cancels, and it has already cleared the display
+    SolveResult result = m_solveWatcher->result();
+    if (result.status == SolveStatus::Cancelled) {
+        return;
+    }
     
     m_progressBar->setVisible(false);
+    m_solveButton->setEnabled(true);
+    
+    if (result.status == SolveStatus::TimedOut) {
+        m_statusLabel->setText("Solving timed out. The puzzle may be invalid or have too few givens.");
+        QMessageBox::warning(this, "Solve Timed Out",
+            QString("No solution was found within %1 seconds.\n"
+                    "Please check if the puzzle was scanned correctly.").arg(SOLVE_TIMEOUT_MS / 1000));
+        return;
+    }
     
-    if (!m_solutionSteps.isEmpty()) {
+    if (result.status == SolveStatus::Solved && !m_sudokuGrid->constraintGraph().isClassic()) {
+        // Variant solves come without steps: show the solution directly
+        m_sudokuGrid->setBoard(result.board);
+        m_solutionSteps.clear();
         m_currentStep = 0;
-        m_statusLabel->setText(QString("Solution found! %1 steps required.").arg(m_solutionSteps.size()));
+        m_statusLabel->setText("Solution found! Step-by-step explanations are only available for classic Sudoku.");
+        
+        updateGridDisplay();
+        updateSolutionDisplay();
+        updateNavigationControls();
+    } else if (result.status == SolveStatus::Solved) {
+        m_solutionSteps = result.steps;
+        if (m_solutionSteps.isEmpty()) {
+            SolutionStep step;
+            step.technique = StepTechnique::AlreadySolved;
+            m_solutionSteps.append(step);
+        }
+        m_currentStep = 0;
+        int difficulty = SudokuSolver::assessDifficulty(m_solutionSteps);
+        m_statusLabel->setText(QString("Solution found! %1 steps required. Difficulty: %2 (%3)")
+                               .arg(m_solutionSteps.size())
+                               .arg(SudokuSolver::getDifficultyLevel(difficulty))
+                               .arg(SudokuSolver::formatRating(difficulty)));
         
         updateSolutionDisplay();
         updateNavigationControls();
@@ -397,8 +473,17 @@ void SudokuWidget::solvePuzzle()
     }
 }
 
+void SudokuWidget::cancelSolve()
+{
+    m_solveToken.cancel();
+    m_solveWatcher->waitForFinished();
+}
+
 void SudokuWidget::resetPuzzle()
 {
+    cancelSolve();
+    m_progressBar->setVisible(false);
+    
     m_sudokuGrid->reset();
     m_solutionSteps.clear();
     m_currentStep = 0;
@@ -493,6 +578,23 @@ void SudokuWidget::cellChanged(int row, int col)
     }
     
     m_sudokuGrid->setValue(row, col, value);
+    updateConflictHighlights();
+}
+
+void SudokuWidget::updateConflictHighlights()
+{
+    // Recolouring items emits cellChanged, which must not write back into the grid
+    QSignalBlocker blocker(m_gridTable);
+    
+    for (const QPoint& cell : m_conflictCells) {
+        m_gridTable->item(cell.x(), cell.y())->setForeground(QColor(0, 0, 0));
+    }
+    
+    // The grid tracks conflicts as cells change, so this reads a bitset
+    m_conflictCells = m_sudokuGrid->getConflictingCells();
+    for (const QPoint& cell : m_conflictCells) {
+        m_gridTable->item(cell.x(), cell.y())->setForeground(QColor(211, 47, 47));
+    }
 }
 
 void SudokuWidget::updateGridDisplay()
@@ -512,6 +614,8 @@ void SudokuWidget::updateGridDisplay()
             }
         }
     }
+    
+    updateConflictHighlights();
 }
 
 void SudokuWidget::updateSolutionDisplay()
@@ -525,12 +629,18 @@ void SudokuWidget::updateSolutionDisplay()
     QString text = "Solution Steps:\n\n";
     for (int i = 0; i < m_solutionSteps.size(); ++i) {
         const SolutionStep& step = m_solutionSteps[i];
-        QString stepText = QString("Step %1: Place %2 at (%3,%4)\nReason: %5\n\n")
+        QString action;
+        if (step.eliminated != 0) {
+            action = QString("Remove %1 from").arg(SudokuSolver::formatDigits(step.eliminated));
+        } else {
+            action = QString("Place %1 at").arg(step.value);
+        }
+        QString stepText = QString("Step %1: %2 (%3,%4)\nReason: %5\n\n")
                           .arg(i + 1)
-                          .arg(step.value)
+                          .arg(action)
                           .arg(step.row + 1)
                           .arg(step.col + 1)
-                          .arg(step.reason);
+                          .arg(SudokuSolver::describeStep(step));
         
         if (i == m_currentStep) {
             text += QString(">>> %1 <<<\n").arg(stepText);
@@ -590,7 +700,9 @@ void SudokuWidget::highlightCurrentStep()
     if (m_currentStep >= 0 && m_currentStep < m_solutionSteps.size()) {
         const SolutionStep& step = m_solutionSteps[m_currentStep];
         QTableWidgetItem *item = m_gridTable->item(step.row, step.col);
-        if (item) {
+        if (item && step.eliminated != 0) {
+            item->setBackground(QColor(144, 202, 249)); // Blue highlight, candidates removed
+        } else if (item) {
             item->setBackground(QColor(255, 235, 59)); // Yellow highlight
             item->setText(QString::number(step.value));
             item->setForeground(QColor(0, 0, 0));
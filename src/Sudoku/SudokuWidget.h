@@ -16,14 +16,17 @@
 #include <QMessageBox>
 #include <QTimer>
 #include <QTableWidget>
+#include <QFutureWatcher>
+#include "SolveControl.h"
 
 class SudokuGrid;
 class SudokuGrid;
 class OCRProcessor;
 class SudokuSolver;
 
-// Forward declare the struct
+// Forward declare the structs
 struct SolutionStep;
+struct SolveResult;
 
 class SudokuWidget : public QWidget
 {
@@ -37,6 +40,8 @@ private slots:
     void loadImage();
     void scanPuzzle();
     void solvePuzzle();
+    void solveFinished();
+    void solveProgress(qint64 nodes, int depth);
     void resetPuzzle();
     void nextStep();
     void prevStep();
@@ -56,7 +61,9 @@ private:
     void updateSolutionDisplay();
     void updateNavigationControls();
     void highlightCurrentStep();
-
+    void updateConflictHighlights();
+    void cancelSolve();
+    
     // UI Components
     QVBoxLayout *m_mainLayout;
     QHBoxLayout *m_contentLayout;
@@ -92,6 +99,13 @@ private:
     OCRProcessor *m_ocrProcessor;
     SudokuSolver *m_sudokuSolver;
     
+    // Solve running in the background
+    QFutureWatcher<SolveResult> *m_solveWatcher;
+    CancellationToken m_solveToken;
+    
+    // Cells currently shown in the conflict colour
+    QVector<QPoint> m_conflictCells;
+    
     // Solution data
     QVector<SolutionStep> m_solutionSteps;
     int m_currentStep;
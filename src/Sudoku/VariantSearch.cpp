@@ -0,0 +1,268 @@
+#include "VariantSearch.h"
+#include <QtAlgorithms>
+
+VariantSearch::VariantSearch(const ConstraintGraph& graph)
+    : m_graph(graph)
+    , m_loaded(false)
+    , m_maxSolutions(1)
+    , m_solutionCount(0)
+    , m_nodesVisited(0)
+    , m_peakDepth(0)
+    , m_propagations(0)
+    , m_monitor(nullptr)
+    , m_stopped(false)
+{
+    m_solution.clear();
+}
+
+bool VariantSearch::load(const SudokuBoard& board)
+{
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        m_root.candidates[cell] = SudokuBoard::ALL_DIGITS;
+        m_root.cells[cell] = 0;
+    }
+    m_root.emptyCount = CELL_COUNT;
+    m_loaded = false;
+    
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        if (board.cells[cell] != 0 && !place(m_root, cell, board.cells[cell])) {
+            return false;
+        }
+    }
+    
+    m_loaded = true;
+    return true;
+}
+
+qint64 VariantSearch::solve(qint64 maxSolutions)
+{
+    m_maxSolutions = maxSolutions;
+    m_solutionCount = 0;
+    m_nodesVisited = 0;
+    m_peakDepth = 0;
+    m_propagations = 0;
+    m_stopped = false;
+    
+    if (m_loaded) {
+        State state = m_root;
+        search(state, 0);
+    }
+    
+    return m_solutionCount;
+}
+
+bool VariantSearch::place(State& state, int cell, int value) const
+{
+    Mask bit = SudokuBoard::digitBit(value);
+    if (!(state.candidates[cell] & bit)) {
+        return false;
+    }
+    
+    state.candidates[cell] = 0;
+    state.cells[cell] = static_cast<quint8>(value);
+    state.emptyCount--;
+    
+    // Every peer of every kind loses the digit
+    const quint8* peers = m_graph.peers(cell);
+    int peerCount = m_graph.peerCount(cell);
+    for (int i = 0; i < peerCount; ++i) {
+        Mask& candidates = state.candidates[peers[i]];
+        if (candidates & bit) {
+            candidates &= ~bit;
+            if (candidates == 0 && state.cells[peers[i]] == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool VariantSearch::propagate(State& state) const
+{
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        
+        // Naked singles
+        for (int cell = 0; cell < CELL_COUNT; ++cell) {
+            Mask candidates = state.candidates[cell];
+            if (state.cells[cell] == 0 && qPopulationCount(candidates) == 1) {
+                if (!place(state, cell, qCountTrailingZeroBits(candidates) + 1)) {
+                    return false;
+                }
+                progress = true;
+            }
+        }
+        
+        if (!applyHiddenSingles(state, progress) || !applySums(state, progress)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A house needs every digit: one with no place left is a contradiction and
+// one with a single place goes there
+bool VariantSearch::applyHiddenSingles(State& state, bool& progress) const
+{
+    for (int unit = 0; unit < m_graph.unitCount(); ++unit) {
+        if (m_graph.unitKind(unit) != ConstraintGraph::UnitKind::House) continue;
+        
+        const quint8* cells = m_graph.unitCells(unit);
+        Mask once = 0;
+        Mask twice = 0;
+        Mask placed = 0;
+        for (int i = 0; i < ConstraintGraph::GRID_SIZE; ++i) {
+            int cell = cells[i];
+            if (state.cells[cell] != 0) {
+                placed |= SudokuBoard::digitBit(state.cells[cell]);
+            } else {
+                twice |= once & state.candidates[cell];
+                once |= state.candidates[cell];
+            }
+        }
+        
+        if ((once | placed) != SudokuBoard::ALL_DIGITS) {
+            return false;
+        }
+        
+        Mask singles = once & ~twice & ~placed;
+        while (singles) {
+            int digit = qCountTrailingZeroBits(singles);
+            singles &= singles - 1;
+            
+            // An earlier single of this unit may have taken the only place
+            Mask bit = Mask(Mask(1) << digit);
+            int target = -1;
+            for (int i = 0; i < ConstraintGraph::GRID_SIZE && target == -1; ++i) {
+                if (state.cells[cells[i]] == 0 && (state.candidates[cells[i]] & bit)) {
+                    target = cells[i];
+                }
+            }
+            if (target == -1 || !place(state, target, digit + 1)) {
+                return false;
+            }
+            progress = true;
+        }
+    }
+    return true;
+}
+
+// Narrows the empty cells of each cage to the digits that can still make up
+// what is left of its sum
+bool VariantSearch::applySums(State& state, bool& progress) const
+{
+    for (quint16 unit : m_graph.sumUnits()) {
+        const quint8* cells = m_graph.unitCells(unit);
+        int size = m_graph.unitSize(unit);
+        int remaining = m_graph.sum(unit);
+        int empty = 0;
+        Mask available = 0;
+        for (int i = 0; i < size; ++i) {
+            int cell = cells[i];
+            if (state.cells[cell] != 0) {
+                remaining -= state.cells[cell];
+            } else {
+                empty++;
+                available |= state.candidates[cell];
+            }
+        }
+        
+        if (empty == 0) {
+            if (remaining != 0) {
+                return false;
+            }
+            continue;
+        }
+        
+        Mask allowed = ConstraintGraph::sumDigits(empty, remaining, available);
+        if (!allowed) {
+            return false;
+        }
+        
+        for (int i = 0; i < size; ++i) {
+            int cell = cells[i];
+            Mask narrowed = state.candidates[cell] & allowed;
+            if (state.cells[cell] == 0 && narrowed != state.candidates[cell]) {
+                if (!narrowed) {
+                    return false;
+                }
+                state.candidates[cell] = narrowed;
+                progress = true;
+            }
+        }
+    }
+    return true;
+}
+
+int VariantSearch::selectCell(const State& state) const
+{
+    int best = -1;
+    int bestCount = ConstraintGraph::GRID_SIZE + 1;
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        if (state.cells[cell] != 0) continue;
+        
+        int count = qPopulationCount(state.candidates[cell]);
+        if (count < bestCount) {
+            best = cell;
+            bestCount = count;
+            if (count == 2) break;
+        }
+    }
+    return best;
+}
+
+void VariantSearch::search(State& state, int depth)
+{
+    m_nodesVisited++;
+    m_peakDepth = qMax(m_peakDepth, depth);
+    
+    if (m_monitor && m_monitor->poll(depth)) {
+        m_stopped = true;
+        return;
+    }
+    
+    int emptyBefore = state.emptyCount;
+    bool consistent = propagate(state);
+    m_propagations += emptyBefore - state.emptyCount;
+    if (!consistent) {
+        return;
+    }
+    
+    if (state.emptyCount == 0) {
+        if (m_solutionCount == 0) {
+            m_solution.clear();
+            for (int cell = 0; cell < CELL_COUNT; ++cell) {
+                m_solution.place(cell / ConstraintGraph::GRID_SIZE, cell % ConstraintGraph::GRID_SIZE,
+                                 state.cells[cell]);
+            }
+        }
+        m_solutionCount++;
+        return;
+    }
+    
+    int cell = selectCell(state);
+    if (cell == -1) {
+        return;
+    }
+    
+    Mask candidates = state.candidates[cell];
+    while (candidates) {
+        int value = qCountTrailingZeroBits(candidates) + 1;
+        candidates &= candidates - 1;
+        
+        State child = state;
+        if (place(child, cell, value)) {
+            search(child, depth + 1);
+        }
+        
+        if (finished()) {
+            return;
+        }
+    }
+}
+
+bool VariantSearch::finished() const
+{
+    return m_stopped || m_solutionCount >= m_maxSolutions;
+}
@@ -0,0 +1,70 @@
+#ifndef VARIANTSEARCH_H
+#define VARIANTSEARCH_H
+
+#include <QtGlobal>
+#include "SudokuBoard.h"
+#include "ConstraintGraph.h"
+#include "SolveControl.h"
+
+// Depth-first search over the candidate masks of a 9x9 variant.
+//
+// The constraints come from a ConstraintGraph, read through its compiled
+// peer and unit tables: placing a digit clears it from the cell's peer
+// list, hidden singles are found per house, and cages narrow their cells to
+// the digits of the sets that can still reach their sum. Every variant runs
+// the same loops over those arrays, so there is no per-constraint dispatch.
+// Branches on the empty cell with the fewest candidates.
+class VariantSearch
+{
+public:
+    typedef SudokuBoard::Mask Mask;
+    
+    explicit VariantSearch(const ConstraintGraph& graph);
+    
+    // Loads the givens of a board; returns false if they already break a constraint
+    bool load(const SudokuBoard& board);
+    
+    // Searches for up to maxSolutions solutions and returns how many were
+    // found; the first one can be read with solution()
+    qint64 solve(qint64 maxSolutions);
+    
+    const SudokuBoard& solution() const { return m_solution; }
+    int nodesVisited() const { return m_nodesVisited; }
+    int peakDepth() const { return m_peakDepth; }
+    qint64 propagations() const { return m_propagations; }
+    
+    // Polls a monitor at every node and stops when it says so
+    void setMonitor(SearchMonitor* monitor) { m_monitor = monitor; }
+
+private:
+    static constexpr int CELL_COUNT = ConstraintGraph::CELL_COUNT;
+    
+    struct State {
+        Mask candidates[CELL_COUNT];    // Remaining digits of each empty cell
+        quint8 cells[CELL_COUNT];       // Placed digits, 0 = empty
+        int emptyCount;
+    };
+    
+    bool place(State& state, int cell, int value) const;
+    bool propagate(State& state) const;
+    bool applyHiddenSingles(State& state, bool& progress) const;
+    bool applySums(State& state, bool& progress) const;
+    int selectCell(const State& state) const;
+    void search(State& state, int depth);
+    bool finished() const;
+    
+    ConstraintGraph m_graph;
+    State m_root;
+    bool m_loaded;
+    SudokuBoard m_solution;
+    
+    qint64 m_maxSolutions;
+    qint64 m_solutionCount;
+    int m_nodesVisited;
+    int m_peakDepth;
+    qint64 m_propagations;
+    SearchMonitor* m_monitor;
+    bool m_stopped;
+};
+
+#endif // VARIANTSEARCH_H
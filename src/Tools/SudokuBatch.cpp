@@ -0,0 +1,554 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QTextStream>
+#include <QVector>
+#include <QtConcurrent>
+#include <cstdio>
+#include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SudokuSolver.h"
+#include "Sudoku/SudokuGenerator.h"
+#include "Sudoku/PuzzleCorpus.h"
+
+// Headless batch solver.
+//
+// Reads one puzzle per line (81 characters, digits for givens and '.' or '0'
+// for empty cells), solves them on every core and writes one line per puzzle
+// in input order: the 81-digit solution, or "unsolvable". With --rate each
+// line is the puzzle followed by its SE-style rating, pearl and diamond, and
+// "stalled" when the techniques could not finish it. With
+// --generate it writes new puzzles in the same format instead. Results are
+// written chunk by chunk, so long runs stream their output.
+//
+// Input files in the packed PuzzleCorpus format are mapped instead of read,
+// and the workers decode their records in place. With --binary, results are
+// appended to a corpus instead: puzzles with their solutions or ratings.
+
+namespace {
+
+const int CHUNK_SIZE = 4096;
+
+struct BatchEntry {
+    SudokuBoard puzzle;     // Givens as read
+    SudokuBoard board;      // Solution once solved
+    bool valid;
+    bool solved;            // Solved, or with --rate finished by the techniques
+    bool rated;             // With --rate: a rating was computed, even if the techniques stalled
+    SudokuRating rating;
+};
+
+// Gives a puzzle of raw cells its digit masks. Returns false if a value is
+// not a digit or two givens conflict; the cells are then left as read.
+bool placeGivens(SudokuBoard& puzzle)
+{
+    SudokuBoard board;
+    board.clear();
+    
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        int value = puzzle.cells[cell];
+        if (value == 0) {
+            continue;
+        }
+        
+        int row = cell / SudokuBoard::GRID_SIZE;
+        int col = cell % SudokuBoard::GRID_SIZE;
+        if (value > SudokuBoard::GRID_SIZE || !board.canPlace(row, col, value)) {
+            return false;
+        }
+        board.place(row, col, value);
+    }
+    
+    puzzle = board;
+    return true;
+}
+
+// Parses a puzzle line. Short lines and conflicting givens make the entry
+// invalid, but the puzzle keeps every given read so its record matches the input.
+void parsePuzzle(const QByteArray& line, BatchEntry& entry)
+{
+    entry.puzzle.clear();
+    entry.board.clear();
+    entry.solved = false;
+    entry.rated = false;
+    
+    int length = qMin(line.size(), int(SudokuBoard::CELL_COUNT));
+    for (int cell = 0; cell < length; ++cell) {
+        char ch = line.at(cell);
+        if (ch >= '1' && ch <= '9') {
+            entry.puzzle.cells[cell] = quint8(ch - '0');
+        }
+    }
+    
+    entry.valid = placeGivens(entry.puzzle) && line.size() >= SudokuBoard::CELL_COUNT;
+    if (entry.valid) {
+        entry.board = entry.puzzle;
+    }
+}
+
+// Decodes a corpus record; conflicting givens make the entry invalid but are
+// kept as stored
+void decodePuzzle(const PuzzleCorpusReader& corpus, qint64 index, BatchEntry& entry)
+{
+    entry.valid = corpus.puzzle(index, entry.puzzle);
+    entry.solved = false;
+    entry.rated = false;
+    
+    if (entry.valid) {
+        entry.board = entry.puzzle;
+        return;
+    }
+    
+    const uchar* packed = corpus.record(index) + PuzzleCorpus::RECORD_HEADER_SIZE;
+    entry.puzzle.clear();
+    entry.board.clear();
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        entry.puzzle.cells[cell] = (packed[cell >> 1] >> ((cell & 1) * 4)) & 0x0F;
+    }
+}
+
+// Solves a contiguous slice of a chunk with one solver per slice
+struct SliceSolver {
+    QVector<BatchEntry>* entries;
+    SolveMode mode;
+    bool lanes;
+    bool rate;
+    int sliceSize;
+    QVector<SolverStatistics>* statistics;   // One per slice, merged after the chunk
+    const PuzzleCorpusReader* corpus;       // Records to decode, or null for parsed text
+    qint64 firstRecord;                     // Record of the chunk's first entry
+    
+    void operator()(int slice) const
+    {
+        SudokuSolver solver;
+        solver.setSolveMode(mode);
+        
+        int begin = slice * sliceSize;
+        int end = qMin(begin + sliceSize, entries->size());
+        
+        if (corpus) {
+            for (int i = begin; i < end; ++i) {
+                decodePuzzle(*corpus, firstRecord + i, (*entries)[i]);
+            }
+        }
+        
+        if (lanes && !rate) {
+            solveInLanes(solver, begin, end);
+        } else {
+            solveEach(solver, begin, end);
+        }
+        (*statistics)[slice] = solver.statistics();
+    }
+    
+    void solveEach(SudokuSolver& solver, int begin, int end) const
+    {
+        for (int i = begin; i < end; ++i) {
+            BatchEntry& entry = (*entries)[i];
+            if (!entry.valid) {
+                continue;
+            }
+            if (rate) {
+                entry.rating = solver.rate(entry.board);
+                // All zero means no solution; a stalled puzzle still gets a rating
+                entry.solved = entry.rating.solved;
+                entry.rated = entry.rating.solved || entry.rating.rating != 0;
+            } else {
+                entry.solved = solver.solve(entry.board);
+            }
+        }
+    }
+    
+    // Packs the valid puzzles of the slice together for SudokuSolver::solveBatch
+    void solveInLanes(SudokuSolver& solver, int begin, int end) const
+    {
+        QVector<SudokuBoard> boards;
+        boards.reserve(end - begin);
+        for (int i = begin; i < end; ++i) {
+            if ((*entries)[i].valid) {
+                boards.append((*entries)[i].board);
+            }
+        }
+        
+        QVector<bool> solved = solver.solveBatch(boards);
+        
+        int next = 0;
+        for (int i = begin; i < end; ++i) {
+            BatchEntry& entry = (*entries)[i];
+            if (entry.valid) {
+                entry.board = boards[next];
+                entry.solved = solved[next];
+                next++;
+            }
+        }
+    }
+};
+
+bool parseMode(const QString& name, SolveMode& mode)
+{
+    if (name == "mrv") {
+        mode = SolveMode::MostConstrained;
+    } else if (name == "dlx") {
+        mode = SolveMode::DancingLinks;
+    } else if (name == "backtrack") {
+        mode = SolveMode::Backtracking;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseDifficulty(const QString& name, PuzzleDifficulty& difficulty)
+{
+    if (name == "easy") {
+        difficulty = PuzzleDifficulty::Easy;
+    } else if (name == "medium") {
+        difficulty = PuzzleDifficulty::Medium;
+    } else if (name == "hard") {
+        difficulty = PuzzleDifficulty::Hard;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Appends a board as 81 characters with '.' for empty cells
+void appendPuzzle(QByteArray& text, const SudokuBoard& board)
+{
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        text.append(board.cells[cell] ? char('0' + board.cells[cell]) : '.');
+    }
+}
+
+// Appends "<puzzle> <rating> <pearl> <diamond>", followed by " stalled" when
+// the techniques could not finish the puzzle, or "<puzzle> unsolvable"
+void appendRating(QByteArray& text, const BatchEntry& entry)
+{
+    appendPuzzle(text, entry.puzzle);
+    if (entry.rated) {
+        text.append(' ');
+        text.append(SudokuSolver::formatRating(entry.rating.rating).toLatin1());
+        text.append(' ');
+        text.append(SudokuSolver::formatRating(entry.rating.pearl).toLatin1());
+        text.append(' ');
+        text.append(SudokuSolver::formatRating(entry.rating.diamond).toLatin1());
+        text.append(entry.solved ? "\n" : " stalled\n");
+    } else {
+        text.append(" unsolvable\n");
+    }
+}
+
+// Appends one result to a corpus: the solution, or the rating when rating.
+// A stalled rating is stored as rated, with its solved byte clear. Returns
+// false once the writer has failed.
+bool appendRecord(PuzzleCorpusWriter& writer, const BatchEntry& entry, bool rate)
+{
+    if (rate) {
+        return entry.rated ? writer.append(entry.puzzle, nullptr, &entry.rating)
+                           : writer.appendUnsolvable(entry.puzzle);
+    }
+    return entry.solved ? writer.append(entry.puzzle, &entry.board)
+                        : writer.appendUnsolvable(entry.puzzle);
+}
+
+// Counts one result: solved or rated, and stalled under the techniques
+void countResult(const BatchEntry& entry, bool rate, qint64& done, qint64& stalled)
+{
+    if (rate) {
+        done += entry.rated ? 1 : 0;
+        stalled += entry.rated && !entry.solved ? 1 : 0;
+    } else {
+        done += entry.solved ? 1 : 0;
+    }
+}
+
+// Writes freshly generated puzzles, one per line with '.' for empty cells, or
+// appends them to a corpus when a writer is given
+int generatePuzzles(const QString& countText, const QString& difficultyName, QFile& output,
+                    PuzzleCorpusWriter* corpus, QTextStream& err)
+{
+    bool countOk = false;
+    int count = countText.toInt(&countOk);
+    if (!countOk || count < 1) {
+        err << "Invalid puzzle count: " << countText << "\n";
+        return 1;
+    }
+    
+    PuzzleDifficulty difficulty;
+    if (!parseDifficulty(difficultyName, difficulty)) {
+        err << "Unknown difficulty: " << difficultyName << "\n";
+        return 1;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    QVector<bool> inBand;
+    QVector<SudokuBoard> puzzles = SudokuGenerator::generateBatch(count, difficulty,
+                                                                  QRandomGenerator::global()->generate(),
+                                                                  &inBand);
+    
+    if (corpus) {
+        for (const SudokuBoard& puzzle : puzzles) {
+            if (!corpus->append(puzzle)) {
+                break;
+            }
+        }
+        if (!corpus->close()) {
+            err << "Cannot write output: " << corpus->errorString() << "\n";
+            return 1;
+        }
+    } else {
+        QByteArray text;
+        text.reserve(count * (SudokuBoard::CELL_COUNT + 1));
+        for (const SudokuBoard& puzzle : puzzles) {
+            appendPuzzle(text, puzzle);
+            text.append('\n');
+        }
+        output.write(text);
+        output.flush();
+    }
+    
+    qint64 elapsed = qMax<qint64>(timer.nsecsElapsed(), 1);
+    err << "Generated " << count << " puzzles in " << QString::number(elapsed / 1e6, 'f', 1) << " ms ("
+        << QString::number(double(count) * 1e9 / double(elapsed), 'f', 0) << " puzzles/sec)\n";
+    int outOfBand = inBand.count(false);
+    if (outOfBand > 0) {
+        err << outOfBand << " puzzles missed the " << difficultyName << " band after "
+            << SudokuGenerator::MAX_HARD_ATTEMPTS << " attempts: singles alone solve them\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("SudokuBatch");
+    app.setApplicationVersion("1.0.0");
+    
+    // The solver logs every solve at debug level; keep the output stream clean
+    QLoggingCategory::setFilterRules("*.debug=false");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Solves or generates Sudoku puzzles in bulk, one puzzle per line.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("input", "Puzzle file or packed corpus to read (default: standard input).");
+    
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Write solutions to <file> (default: standard output).", "file");
+    QCommandLineOption modeOption(QStringList() << "m" << "mode",
+                                  "Search engine: mrv, dlx or backtrack (default: mrv).", "mode", "mrv");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads",
+                                     "Number of worker threads (default: all cores).", "count");
+    QCommandLineOption lanesOption(QStringList() << "l" << "lanes",
+                                   "Propagate 16 puzzles at a time in SIMD lanes; <mode> handles the rest.");
+    QCommandLineOption rateOption(QStringList() << "r" << "rate",
+                                  "Rate puzzles instead of solving: rating, pearl and diamond, SE style.");
+    QCommandLineOption generateOption(QStringList() << "g" << "generate",
+                                      "Generate <count> unique puzzles instead of solving.", "count");
+    QCommandLineOption statsOption(QStringList() << "s" << "stats",
+                                   "Print solver statistics to standard error when done.");
+    QCommandLineOption binaryOption(QStringList() << "b" << "binary",
+                                    "Append results to <output> as a packed corpus instead of text.");
+    QCommandLineOption difficultyOption(QStringList() << "d" << "difficulty",
+                                        "Generated difficulty: easy, medium or hard (default: medium).",
+                                        "level", "medium");
+    parser.addOption(outputOption);
+    parser.addOption(modeOption);
+    parser.addOption(threadsOption);
+    parser.addOption(lanesOption);
+    parser.addOption(rateOption);
+    parser.addOption(generateOption);
+    parser.addOption(difficultyOption);
+    parser.addOption(statsOption);
+    parser.addOption(binaryOption);
+    parser.process(app);
+    
+    QTextStream err(stderr);
+    
+    SolveMode mode;
+    if (!parseMode(parser.value(modeOption), mode)) {
+        err << "Unknown mode: " << parser.value(modeOption) << "\n";
+        return 1;
+    }
+    
+    QThreadPool* pool = QThreadPool::globalInstance();
+    if (parser.isSet(threadsOption)) {
+        int threads = parser.value(threadsOption).toInt();
+        if (threads < 1) {
+            err << "Invalid thread count: " << parser.value(threadsOption) << "\n";
+            return 1;
+        }
+        pool->setMaxThreadCount(threads);
+    }
+    
+    bool rate = parser.isSet(rateOption);
+    bool generate = parser.isSet(generateOption);
+    
+    // Open output and input. A corpus is appended to, so it is never truncated.
+    QFile output;
+    PuzzleCorpusWriter corpusOutput;
+    bool binary = parser.isSet(binaryOption);
+    if (binary) {
+        if (!parser.isSet(outputOption)) {
+            err << "--binary needs an output file\n";
+            return 1;
+        }
+        quint16 payloads = generate ? 0 : rate ? PuzzleCorpus::HasRating : PuzzleCorpus::HasSolution;
+        if (!corpusOutput.open(parser.value(outputOption), payloads)) {
+            err << "Cannot open output: " << corpusOutput.errorString() << "\n";
+            return 1;
+        }
+    } else {
+        bool outputOpened;
+        if (parser.isSet(outputOption)) {
+            output.setFileName(parser.value(outputOption));
+            outputOpened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        } else {
+            outputOpened = output.open(stdout, QIODevice::WriteOnly);
+        }
+        if (!outputOpened) {
+            err << "Cannot open output: " << output.errorString() << "\n";
+            return 1;
+        }
+    }
+    
+    // Generation mode writes puzzles instead of reading them
+    if (generate) {
+        return generatePuzzles(parser.value(generateOption), parser.value(difficultyOption), output,
+                               binary ? &corpusOutput : nullptr, err);
+    }
+    
+    QFile input;
+    PuzzleCorpusReader corpus;
+    const QStringList positional = parser.positionalArguments();
+    bool inputOpened;
+    if (positional.isEmpty()) {
+        inputOpened = input.open(stdin, QIODevice::ReadOnly);
+    } else if (PuzzleCorpus::isCorpusFile(positional.first())) {
+        inputOpened = corpus.open(positional.first());
+    } else {
+        input.setFileName(positional.first());
+        inputOpened = input.open(QIODevice::ReadOnly);
+    }
+    if (!inputOpened) {
+        err << "Cannot open input: " << (corpus.errorString().isEmpty() ? input.errorString()
+                                                                         : corpus.errorString()) << "\n";
+        return 1;
+    }
+    
+    // Enough slices per chunk to keep every worker busy when puzzle costs vary
+    const int sliceCount = qMax(1, pool->maxThreadCount() * 8);
+    
+    QVector<BatchEntry> entries;
+    entries.reserve(CHUNK_SIZE);
+    QByteArray text;
+    text.reserve(CHUNK_SIZE * (SudokuBoard::CELL_COUNT + 1));
+    
+    qint64 total = 0;
+    qint64 solved = 0;
+    qint64 stalled = 0;
+    SolverStatistics statistics(SudokuSolver::techniqueNames());
+    QVector<SolverStatistics> sliceStatistics;
+    QElapsedTimer timer;
+    timer.start();
+    
+    qint64 nextRecord = 0;
+    while (corpus.isOpen() ? nextRecord < corpus.count() : !input.atEnd()) {
+        entries.clear();
+        if (corpus.isOpen()) {
+            // Records are decoded by the workers straight from the mapping
+            entries.resize(int(qMin<qint64>(CHUNK_SIZE, corpus.count() - nextRecord)));
+        } else {
+            // Read the next chunk, skipping blank lines and '#' comments
+            while (entries.size() < CHUNK_SIZE && !input.atEnd()) {
+                QByteArray line = input.readLine().trimmed();
+                if (line.isEmpty() || line.startsWith('#')) {
+                    continue;
+                }
+                entries.append(BatchEntry());
+                parsePuzzle(line, entries.last());
+            }
+        }
+        
+        if (entries.isEmpty()) {
+            break;
+        }
+        
+        // Solve the chunk across the pool
+        SliceSolver solver = { &entries, mode, parser.isSet(lanesOption), rate,
+                               (entries.size() + sliceCount - 1) / sliceCount, &sliceStatistics,
+                               corpus.isOpen() ? &corpus : nullptr, nextRecord };
+        nextRecord += entries.size();
+        QVector<int> slices;
+        for (int slice = 0; slice * solver.sliceSize < entries.size(); ++slice) {
+            slices.append(slice);
+        }
+        sliceStatistics.fill(SolverStatistics(), slices.size());
+        QtConcurrent::blockingMap(slices, solver);
+        for (const SolverStatistics& slice : sliceStatistics) {
+            statistics.merge(slice);
+        }
+        
+        // Write results in input order
+        total += entries.size();
+        if (binary) {
+            for (const BatchEntry& entry : entries) {
+                if (!appendRecord(corpusOutput, entry, rate)) {
+                    err << "Cannot write output: " << corpusOutput.errorString() << "\n";
+                    return 1;
+                }
+                countResult(entry, rate, solved, stalled);
+            }
+            continue;
+        }
+        
+        text.clear();
+        for (const BatchEntry& entry : entries) {
+            countResult(entry, rate, solved, stalled);
+            if (rate) {
+                appendRating(text, entry);
+            } else if (entry.solved) {
+                for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+                    text.append(char('0' + entry.board.cells[cell]));
+                }
+                text.append('\n');
+            } else {
+                text.append("unsolvable\n");
+            }
+        }
+        output.write(text);
+        output.flush();
+    }
+    
+    if (binary) {
+        if (!corpusOutput.close()) {
+            err << "Cannot write output: " << corpusOutput.errorString() << "\n";
+            return 1;
+        }
+    } else {
+        output.flush();
+    }
+    
+    qint64 elapsed = qMax<qint64>(timer.nsecsElapsed(), 1);
+    double perSecond = double(total) * 1e9 / double(elapsed);
+    err << (rate ? "Rated " : "Solved ") << solved << " of " << total << " puzzles in "
+        << QString::number(elapsed / 1e6, 'f', 1) << " ms ("
+        << QString::number(perSecond, 'f', 0) << " puzzles/sec, "
+        << pool->maxThreadCount() << " threads)\n";
+    if (rate && stalled > 0) {
+        err << stalled << " puzzles stalled: the techniques could not finish them, so they rate "
+            << SudokuSolver::formatRating(SudokuSolver::RATING_BEYOND_TECHNIQUES) << "\n";
+    }
+    
+    if (parser.isSet(statsOption)) {
+        err << statistics.report() << "\n";
+    }
+    
+    return 0;
+}
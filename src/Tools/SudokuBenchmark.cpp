@@ -0,0 +1,430 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SudokuGrid.h"
+#include "Sudoku/SudokuSolver.h"
+#include "Sudoku/CandidateKernel.h"
+
+// Sudoku engine benchmark.
+//
+// Runs solve() in every mode, solveWithSteps(), isUniqueSolution(), rate() and
+// SudokuGrid::isValid() over embedded corpora and writes ns, search nodes and
+// heap allocations per puzzle as JSON, so results can be compared between
+// releases.
+
+namespace {
+
+// Heap allocations on any thread since start-up
+std::atomic<quint64> g_allocations(0);
+
+inline void countAllocation()
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+#ifdef __GLIBC__
+
+// Qt containers allocate with malloc, so count there; operator new ends up here too
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+}
+
+#else
+
+// Elsewhere only C++ allocations are visible
+void* operator new(size_t size)
+{
+    countAllocation();
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif // __GLIBC__
+
+namespace {
+
+// Embedded corpora; each is expanded with random isomorphs to the requested size
+struct Corpus {
+    const char* name;
+    const char* const* puzzles;
+};
+
+const char* const EASY_PUZZLES[] = {
+    "003020600900305001001806400008102900700000008006708200002609500800203009005010300",
+    "200080300060070084030500209000105408000000000402706000301007040720040060004010003",
+    "000000907000420180000705026100904000050000040000507009920108000034059000507000000",
+    "030050040008010500460000012070502080000603000040109030250000098001020600080060020",
+    "020810740700003100090002805009040087400208003160030200302700060005600008076051090",
+    nullptr
+};
+
+// From Gordon Royle's collection of minimal puzzles
+const char* const SEVENTEEN_CLUE_PUZZLES[] = {
+    "000000010400000000020000000000050407008000300001090000300400200050100000000806000",
+    "000000010400000000020000000000050604008000300001090000300400200050100000000807000",
+    "000000012000035000000600070700000300000400800100000000000120000080000040050000600",
+    "000000012003600000000007000410020000000500300700000600280000040000300500000000000",
+    "000000012008030000000000040120500000000004700060000000507000300000620000000100000",
+    nullptr
+};
+
+// Inkala's "hardest", AI Escargot, Golden Nugget, Platinum Blonde and Easter Monster
+const char* const HARDEST_PUZZLES[] = {
+    "800000000003600000070090200050007000000045700000100030001000068008500010090000400",
+    "100007090030020008009600500005300900010080002600004000300000010040000007007000300",
+    "000000039000001005003050800008090006070002000100400000009080050020000600400700000",
+    "000000012000000003002300400001800005060070800000009000008500000900040500470006000",
+    "100000002090400050006000700050903000000070000000850040700000600030009080002000001",
+    nullptr
+};
+
+const Corpus CORPORA[] = {
+    { "easy", EASY_PUZZLES },
+    { "17-clue", SEVENTEEN_CLUE_PUZZLES },
+    { "hardest", HARDEST_PUZZLES }
+};
+
+SudokuBoard parseBoard(const char* text)
+{
+    SudokuBoard board;
+    board.clear();
+    for (int cell = 0; cell < SudokuBoard::CELL_COUNT; ++cell) {
+        int value = text[cell] - '0';
+        if (value > 0) {
+            board.place(cell / SudokuBoard::GRID_SIZE, cell % SudokuBoard::GRID_SIZE, value);
+        }
+    }
+    return board;
+}
+
+void shuffle(int* values, int count, QRandomGenerator& random)
+{
+    for (int i = count - 1; i > 0; --i) {
+        qSwap(values[i], values[random.bounded(i + 1)]);
+    }
+}
+
+// Random order of nine lines that keeps bands (or stacks) together
+void shuffleLines(int lines[9], QRandomGenerator& random)
+{
+    int bands[3] = { 0, 1, 2 };
+    shuffle(bands, 3, random);
+    for (int band = 0; band < 3; ++band) {
+        int inner[3] = { 0, 1, 2 };
+        shuffle(inner, 3, random);
+        for (int i = 0; i < 3; ++i) {
+            lines[band * 3 + i] = bands[band] * 3 + inner[i];
+        }
+    }
+}
+
+// Same puzzle under a random symmetry, so the search sees a different board of equal difficulty
+SudokuBoard randomIsomorph(const SudokuBoard& source, QRandomGenerator& random)
+{
+    int rows[9];
+    int cols[9];
+    int digits[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    shuffleLines(rows, random);
+    shuffleLines(cols, random);
+    shuffle(digits + 1, 9, random);
+    bool transposed = random.bounded(2) != 0;
+    
+    SudokuBoard board;
+    board.clear();
+    for (int row = 0; row < 9; ++row) {
+        for (int col = 0; col < 9; ++col) {
+            int value = transposed ? source.value(cols[col], rows[row]) : source.value(rows[row], cols[col]);
+            if (value != 0) {
+                board.place(row, col, digits[value]);
+            }
+        }
+    }
+    return board;
+}
+
+QVector<SudokuBoard> buildCorpus(const Corpus& corpus, int size, quint32 seed)
+{
+    QVector<SudokuBoard> boards;
+    for (int i = 0; corpus.puzzles[i]; ++i) {
+        boards.append(parseBoard(corpus.puzzles[i]));
+    }
+    
+    QRandomGenerator random(seed);
+    int embedded = boards.size();
+    for (int i = embedded; i < size; ++i) {
+        boards.append(randomIsomorph(boards[i % embedded], random));
+    }
+    boards.resize(size);
+    return boards;
+}
+
+struct Measurement {
+    qint64 nanoseconds;
+    qint64 nodes;
+    quint64 allocations;
+    int succeeded;
+};
+
+// One benchmark over one corpus: prepare() runs untimed, run() is timed and
+// reports success; run() is repeated innerLoops times per puzzle for very
+// cheap operations. Keeps the fastest of several passes.
+Measurement measure(const QVector<SudokuBoard>& boards, int passes, int innerLoops,
+                    const std::function<void(const SudokuBoard&)>& prepare,
+                    const std::function<bool()>& run,
+                    const std::function<int()>& nodes)
+{
+    Measurement best = { -1, 0, 0, 0 };
+    QElapsedTimer timer;
+    
+    for (int pass = 0; pass < passes; ++pass) {
+        Measurement current = { 0, 0, 0, 0 };
+        
+        for (const SudokuBoard& board : boards) {
+            prepare(board);
+            
+            quint64 allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+            timer.start();
+            bool ok = false;
+            for (int i = 0; i < innerLoops; ++i) {
+                ok = run();
+            }
+            current.nanoseconds += timer.nsecsElapsed();
+            current.allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+            
+            current.nodes += nodes();
+            if (ok) {
+                current.succeeded++;
+            }
+        }
+        
+        if (best.nanoseconds < 0 || current.nanoseconds < best.nanoseconds) {
+            best = current;
+        }
+    }
+    
+    return best;
+}
+
+QJsonObject toJson(const QString& benchmark, const Corpus& corpus, int puzzles, int innerLoops,
+                   const Measurement& result)
+{
+    double calls = double(puzzles) * innerLoops;
+    
+    QJsonObject object;
+    object["benchmark"] = benchmark;
+    object["corpus"] = QString(corpus.name);
+    object["puzzles"] = puzzles;
+    object["succeeded"] = result.succeeded;
+    object["nsPerPuzzle"] = double(result.nanoseconds) / calls;
+    object["nodesPerPuzzle"] = double(result.nodes) / puzzles;
+    object["allocationsPerPuzzle"] = double(result.allocations) / calls;
+    return object;
+}
+
+bool parseCount(const QString& text, int& value)
+{
+    bool ok = false;
+    value = text.toInt(&ok);
+    return ok && value > 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("SudokuBenchmark");
+    app.setApplicationVersion("1.0.0");
+    
+    // The solver logs every solve at debug level, which would dominate the timings
+    QLoggingCategory::setFilterRules("*.debug=false");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the Sudoku engine and writes the results as JSON.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Write JSON to <file> (default: standard output).", "file");
+    QCommandLineOption sizeOption(QStringList() << "n" << "puzzles",
+                                  "Puzzles per corpus, padded with isomorphs (default: 200).", "count", "200");
+    QCommandLineOption passesOption(QStringList() << "p" << "passes",
+                                    "Passes per benchmark; the fastest is reported (default: 3).", "count", "3");
+    QCommandLineOption seedOption(QStringList() << "s" << "seed",
+                                  "Seed for the isomorph generator (default: 1).", "seed", "1");
+    QCommandLineOption cacheOption(QStringList() << "c" << "cache",
+                                   "Keep the solve cache enabled (measures cache hits after the first pass).");
+    parser.addOption(outputOption);
+    parser.addOption(sizeOption);
+    parser.addOption(passesOption);
+    parser.addOption(seedOption);
+    parser.addOption(cacheOption);
+    parser.process(app);
+    
+    QTextStream err(stderr);
+    
+    int corpusSize;
+    int passes;
+    if (!parseCount(parser.value(sizeOption), corpusSize)) {
+        err << "Invalid puzzle count: " << parser.value(sizeOption) << "\n";
+        return 1;
+    }
+    if (!parseCount(parser.value(passesOption), passes)) {
+        err << "Invalid pass count: " << parser.value(passesOption) << "\n";
+        return 1;
+    }
+    quint32 seed = parser.value(seedOption).toUInt();
+    bool useCache = parser.isSet(cacheOption);
+    
+    QFile output;
+    bool outputOpened;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        outputOpened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        outputOpened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!outputOpened) {
+        err << "Cannot open output: " << output.errorString() << "\n";
+        return 1;
+    }
+    
+    struct ModeEntry {
+        const char* name;
+        SolveMode mode;
+    };
+    const ModeEntry modes[] = {
+        { "solve.backtrack", SolveMode::Backtracking },
+        { "solve.dlx", SolveMode::DancingLinks },
+        { "solve.mrv", SolveMode::MostConstrained }
+    };
+    
+    // isValid() takes tens of nanoseconds, too short to time one call at a time
+    const int VALIDITY_LOOPS = 256;
+    
+    SudokuGrid grid;
+    SudokuSolver solver;
+    solver.setCacheEnabled(useCache);
+    QJsonArray results;
+    
+    auto prepareGrid = [&grid](const SudokuBoard& board) { grid.setBoard(board); };
+    auto solverNodes = [&solver]() { return solver.searchNodes(); };
+    auto noNodes = []() { return 0; };
+    
+    for (const Corpus& corpus : CORPORA) {
+        QVector<SudokuBoard> boards = buildCorpus(corpus, corpusSize, seed);
+        
+        for (const ModeEntry& entry : modes) {
+            solver.setSolveMode(entry.mode);
+            Measurement result = measure(boards, passes, 1, prepareGrid,
+                                         [&]() { return solver.solve(&grid); }, solverNodes);
+            results.append(toJson(entry.name, corpus, boards.size(), 1, result));
+        }
+        
+        solver.setSolveMode(SolveMode::Backtracking);
+        Measurement steps = measure(boards, passes, 1, prepareGrid,
+                                    [&]() { return !solver.solveWithSteps(&grid).isEmpty(); }, solverNodes);
+        results.append(toJson("solveWithSteps", corpus, boards.size(), 1, steps));
+        
+        Measurement unique = measure(boards, passes, 1, prepareGrid,
+                                     [&]() { return solver.isUniqueSolution(&grid); }, solverNodes);
+        results.append(toJson("isUniqueSolution", corpus, boards.size(), 1, unique));
+        
+        SudokuBoard current;
+        Measurement rating = measure(boards, passes, 1, [&current](const SudokuBoard& board) { current = board; },
+                                     [&]() { return solver.rate(current).solved; }, noNodes);
+        results.append(toJson("rate", corpus, boards.size(), 1, rating));
+        
+        Measurement valid = measure(boards, passes, VALIDITY_LOOPS, prepareGrid,
+                                    [&]() { return grid.isValid(); }, noNodes);
+        results.append(toJson("isValid", corpus, boards.size(), VALIDITY_LOOPS, valid));
+    }
+    
+    QJsonObject report;
+    report["tool"] = app.applicationName();
+    report["version"] = app.applicationVersion();
+    report["qtVersion"] = QString(qVersion());
+    report["avx2"] = CandidateKernel::usesAvx2();
+    report["cache"] = useCache;
+    report["passes"] = passes;
+    report["seed"] = qint64(seed);
+    report["results"] = results;
+    
+    output.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    output.flush();
+    
+    // Short table for people reading the terminal
+    for (const QJsonValue& value : results) {
+        QJsonObject object = value.toObject();
+        err << QString("%1 %2 %3 ns  %4 nodes  %5 allocs\n")
+               .arg(object["benchmark"].toString(), -18)
+               .arg(object["corpus"].toString(), -8)
+               .arg(object["nsPerPuzzle"].toDouble(), 12, 'f', 0)
+               .arg(object["nodesPerPuzzle"].toDouble(), 10, 'f', 1)
+               .arg(object["allocationsPerPuzzle"].toDouble(), 8, 'f', 1);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "SolverStatistics.h"
+#include <cstring>
+#include <limits>
+
+StatHistogram::StatHistogram()
+{
+    clear();
+}
+
+void StatHistogram::merge(const StatHistogram& other)
+{
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        m_buckets[bucket] += other.m_buckets[bucket];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = qMin(m_min, other.m_min);
+    m_max = qMax(m_max, other.m_max);
+}
+
+void StatHistogram::clear()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum = 0;
+    m_min = std::numeric_limits<quint64>::max();
+    m_max = 0;
+}
+
+quint64 StatHistogram::percentile(double fraction) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    
+    quint64 target = qMax<quint64>(1, quint64(fraction * double(m_count) + 0.5));
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += m_buckets[bucket];
+        if (seen >= target) {
+            quint64 limit = bucket == 0 ? 0 : (quint64(1) << bucket) - 1;
+            return qMin(limit, m_max);
+        }
+    }
+    return m_max;
+}
+
+QString StatHistogram::summary(const QString& unit) const
+{
+    return QString("n=%1 mean=%2%7 p50<=%3%7 p90<=%4%7 p99<=%5%7 max=%6%7")
+        .arg(m_count)
+        .arg(mean(), 0, 'f', 1)
+        .arg(percentile(0.50))
+        .arg(percentile(0.90))
+        .arg(percentile(0.99))
+        .arg(m_max)
+        .arg(unit);
+}
+
+SolverStatistics::SolverStatistics(const QStringList& techniqueNames)
+    : m_techniqueNames(techniqueNames.mid(0, SolveCounters::MAX_TECHNIQUES))
+    , m_solves(0)
+    , m_solved(0)
+    , m_peakDepth(0)
+    , m_techniqueHits(m_techniqueNames.size())
+    , m_techniqueTimeNs(m_techniqueNames.size())
+{
+}
+
+void SolverStatistics::record(const SolveCounters& solve)
+{
+    m_solves++;
+    m_solved += solve.solved ? 1 : 0;
+    m_peakDepth = qMax(m_peakDepth, solve.peakDepth);
+    
+    m_nodes.add(quint64(solve.nodes));
+    m_propagations.add(quint64(solve.propagations));
+    m_depth.add(quint64(solve.peakDepth));
+    m_stepBufferGrowths.add(quint64(solve.stepBufferGrowths));
+    m_wallTimeUs.add(quint64(solve.wallTimeNs / 1000));
+    
+    for (int technique = 0; technique < m_techniqueNames.size(); ++technique) {
+        if (solve.techniqueTimeNs[technique] > 0 || solve.techniqueHits[technique] > 0) {
+            m_techniqueHits[technique].add(solve.techniqueHits[technique]);
+            m_techniqueTimeNs[technique].add(quint64(solve.techniqueTimeNs[technique]));
+        }
+    }
+}
+
+void SolverStatistics::merge(const SolverStatistics& other)
+{
+    if (m_techniqueNames.isEmpty()) {
+        m_techniqueNames = other.m_techniqueNames;
+        m_techniqueHits.resize(m_techniqueNames.size());
+        m_techniqueTimeNs.resize(m_techniqueNames.size());
+    }
+    
+    m_solves += other.m_solves;
+    m_solved += other.m_solved;
+    m_peakDepth = qMax(m_peakDepth, other.m_peakDepth);
+    
+    m_nodes.merge(other.m_nodes);
+    m_propagations.merge(other.m_propagations);
+    m_depth.merge(other.m_depth);
+    m_stepBufferGrowths.merge(other.m_stepBufferGrowths);
+    m_wallTimeUs.merge(other.m_wallTimeUs);
+    
+    // Both sides number techniques the same way when they come from one solver type
+    int count = qMin(m_techniqueNames.size(), other.m_techniqueNames.size());
+    for (int technique = 0; technique < count; ++technique) {
+        m_techniqueHits[technique].merge(other.m_techniqueHits[technique]);
+        m_techniqueTimeNs[technique].merge(other.m_techniqueTimeNs[technique]);
+    }
+}
+
+void SolverStatistics::clear()
+{
+    *this = SolverStatistics(m_techniqueNames);
+}
+
+QString SolverStatistics::report() const
+{
+    QStringList lines;
+    lines << QString("solves: %1 (%2 solved), peak depth %3").arg(m_solves).arg(m_solved).arg(m_peakDepth);
+    lines << "nodes:        " + m_nodes.summary();
+    lines << "propagations: " + m_propagations.summary();
+    lines << "depth:        " + m_depth.summary();
+    lines << "step growths: " + m_stepBufferGrowths.summary();
+    lines << "wall time:    " + m_wallTimeUs.summary("us");
+    
+    for (int technique = 0; technique < m_techniqueNames.size(); ++technique) {
+        if (m_techniqueHits[technique].count() == 0) continue;
+        
+        lines << QString("%1: hits %2, %3 total; time %4")
+                 .arg(m_techniqueNames[technique])
+                 .arg(m_techniqueHits[technique].summary())
+                 .arg(m_techniqueHits[technique].sum())
+                 .arg(m_techniqueTimeNs[technique].summary("ns"));
+    }
+    return lines.join('\n');
+}
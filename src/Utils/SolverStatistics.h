@@ -0,0 +1,133 @@
+#ifndef SOLVERSTATISTICS_H
+#define SOLVERSTATISTICS_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Histogram of non-negative samples in power-of-two buckets. Bucket 0 counts
+// zeros and bucket i counts samples in [2^(i-1), 2^i), so adding a sample is
+// one count-leading-zeros and a few increments.
+class StatHistogram
+{
+public:
+    static constexpr int BUCKET_COUNT = 48;
+    
+    StatHistogram();
+    
+    void add(quint64 value)
+    {
+        int bucket = value == 0 ? 0 : 64 - qCountLeadingZeroBits(value);
+        m_buckets[qMin(bucket, BUCKET_COUNT - 1)]++;
+        m_count++;
+        m_sum += value;
+        m_min = qMin(m_min, value);
+        m_max = qMax(m_max, value);
+    }
+    
+    void merge(const StatHistogram& other);
+    void clear();
+    
+    quint64 count() const { return m_count; }
+    quint64 sum() const { return m_sum; }
+    quint64 minimum() const { return m_count ? m_min : 0; }
+    quint64 maximum() const { return m_max; }
+    double mean() const { return m_count ? double(m_sum) / double(m_count) : 0.0; }
+    quint64 bucketCount(int bucket) const { return m_buckets[bucket]; }
+    
+    // Upper bound of the bucket reaching the given fraction of samples, capped
+    // at the largest sample, e.g. percentile(0.99)
+    quint64 percentile(double fraction) const;
+    
+    // One line: "n=120 mean=35.2 p50<=32 p90<=64 p99<=128 max=97", each value
+    // followed by unit
+    QString summary(const QString& unit = QString()) const;
+
+private:
+    quint64 m_buckets[BUCKET_COUNT];
+    quint64 m_count;
+    quint64 m_sum;
+    quint64 m_min;
+    quint64 m_max;
+};
+
+// Plain counters of one solve, bumped by a solver as it works and folded
+// into SolverStatistics when the solve ends
+struct SolveCounters
+{
+    static constexpr int MAX_TECHNIQUES = 32;
+    
+    qint64 nodes = 0;           // Search nodes visited
+    qint64 propagations = 0;    // Cells filled by deduction rather than by guessing
+    int peakDepth = 0;          // Deepest guess level
+    // Growths of the recorded-step buffer. Only step recording is counted:
+    // the search engines, parallel counting and the solve cache allocate
+    // without showing up here.
+    qint64 stepBufferGrowths = 0;
+    qint64 wallTimeNs = 0;
+    bool solved = false;
+    
+    // Indexed by the solver's technique numbering
+    quint32 techniqueHits[MAX_TECHNIQUES] = {};
+    qint64 techniqueTimeNs[MAX_TECHNIQUES] = {};
+    
+    void addTechnique(int technique, bool hit, qint64 elapsedNs)
+    {
+        techniqueHits[technique] += hit ? 1 : 0;
+        techniqueTimeNs[technique] += elapsedNs;
+    }
+};
+
+// Totals and per-solve histograms over any number of solves.
+//
+// record() costs a few dozen increments per solve, so solvers keep it on
+// all the time. Statistics of solvers running on different threads are
+// combined with merge(), which is how batch runs aggregate their workers.
+class SolverStatistics
+{
+public:
+    explicit SolverStatistics(const QStringList& techniqueNames = QStringList());
+    
+    void record(const SolveCounters& solve);
+    void merge(const SolverStatistics& other);
+    void clear();
+    
+    qint64 solves() const { return m_solves; }
+    qint64 solved() const { return m_solved; }
+    int peakDepth() const { return m_peakDepth; }
+    
+    // Per-solve distributions; sum() gives the totals
+    const StatHistogram& nodes() const { return m_nodes; }
+    const StatHistogram& propagations() const { return m_propagations; }
+    const StatHistogram& depth() const { return m_depth; }
+    const StatHistogram& stepBufferGrowths() const { return m_stepBufferGrowths; }
+    const StatHistogram& wallTimeUs() const { return m_wallTimeUs; }
+    
+    // Per technique: hits per solve and time spent in it per solve. Solves
+    // that never tried a technique are left out of its histograms.
+    int techniqueCount() const { return m_techniqueNames.size(); }
+    QString techniqueName(int technique) const { return m_techniqueNames[technique]; }
+    const StatHistogram& techniqueHits(int technique) const { return m_techniqueHits[technique]; }
+    const StatHistogram& techniqueTimeNs(int technique) const { return m_techniqueTimeNs[technique]; }
+    
+    // Multi-line human-readable report
+    QString report() const;
+
+private:
+    QStringList m_techniqueNames;
+    qint64 m_solves;
+    qint64 m_solved;
+    int m_peakDepth;
+    
+    StatHistogram m_nodes;
+    StatHistogram m_propagations;
+    StatHistogram m_depth;
+    StatHistogram m_stepBufferGrowths;
+    StatHistogram m_wallTimeUs;
+    QVector<StatHistogram> m_techniqueHits;
+    QVector<StatHistogram> m_techniqueTimeNs;
+};
+
+#endif // SOLVERSTATISTICS_H